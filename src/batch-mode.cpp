@@ -0,0 +1,171 @@
+#include "batch-mode.hpp"
+
+#include <fdt/fdt-loader.hpp>
+#include <fdt/fdt-view.hpp>
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <string_view>
+
+namespace {
+constexpr std::array<std::string_view, 4> REPORT_OPTIONS{"--dump", "--query", "--search", "--stats"};
+
+struct report {
+    string output;
+    string errors;
+};
+
+// reports cover the whole tree, embedded blobs included
+void expand_all(fdt::tree &value) {
+    for (fdt::index id = 0; id < value.nodes.size(); ++id)
+        fdt::commit_expansion(value, fdt::prepare_expansion(value, id));
+}
+
+auto collect_inputs(const string_list &inputs) -> string_list {
+    string_list ret;
+    for (auto &&input : inputs) {
+        if (!file_info(input).isDir()) {
+            ret.append(input);
+            continue;
+        }
+
+        // directories are scanned like File → Open Directory, sorted so runs are reproducible
+        string_list found;
+        QDirIterator iter(input, {"*.dtb", "*.dtbo"}, QDir::Files);
+        while (iter.hasNext())
+            found.append(iter.next());
+
+        found.sort();
+        ret.append(found);
+    }
+
+    return ret;
+}
+
+auto query(tree_info &info, const string &path) -> std::optional<string> {
+    const auto target = path.toStdString();
+    const auto &tree = info.tree;
+
+    if (const auto node = fdt::find_path(tree, target); fdt::npos != node)
+        return fdt::fdt_view_dts(info, node);
+
+    // the last component may name a property instead
+    const auto separator = target.rfind('/');
+    if (std::string::npos == separator)
+        return {};
+
+    const auto parent = fdt::find_path(tree, separator ? target.substr(0, separator) : "/");
+    if (fdt::npos == parent)
+        return {};
+
+    if (const auto property = fdt::find_property(tree, parent, std::string_view(target).substr(separator + 1)))
+        return fdt::fdt_view_property(info, static_cast<fdt::index>(property - tree.properties.data())) + "\n";
+
+    return {};
+}
+
+auto stats(const tree_info &info) -> string {
+    const auto &tree = info.tree;
+
+    // parents are stored before their children
+    std::vector<u32> depth(tree.nodes.size(), 0);
+    for (fdt::index id = 1; id < tree.nodes.size(); ++id)
+        depth[id] = depth[tree.nodes[id].parent] + 1;
+
+    return QString("%1 nodes, %2 properties, %3 bytes, depth %4")
+        .arg(tree.nodes.size())
+        .arg(tree.properties.size())
+        .arg(tree.blobs.front().data.size())
+        .arg(depth.empty() ? 0 : *std::ranges::max_element(depth));
+}
+
+auto process(const batch::options &options, const string &path) -> report {
+    // files are read once, nothing watches them
+    auto loaded = fdt::load_tree(path, fdt::parse_mode::full, {}, fdt::file_access::map);
+    if (!loaded.tree)
+        return {{}, path + ": not a valid devicetree blob\n"};
+
+    tree_info info;
+    info.id = path;
+    info.name = "/";
+    info.tree = std::move(*loaded.tree);
+    expand_all(info.tree);
+    info.hidden.assign(info.tree.nodes.size(), 0);
+
+    report ret;
+
+    if (options.dump)
+        ret.output += "// " + path + "\n/dts-v1/;\n\n" + fdt::fdt_view_dts(info, 0);
+
+    if (options.query) {
+        if (const auto text = query(info, options.query.value()))
+            ret.output += "// " + path + ":" + options.query.value() + "\n" + text.value();
+        else
+            ret.errors += path + ": " + options.query.value() + " not found\n";
+    }
+
+    if (options.search) {
+        const std::atomic_bool cancelled{false};
+        fdt::prepare_search(info);
+        if (const auto found = fdt::fdt_content_search(info, options.search.value(), cancelled))
+            for (fdt::index id = 0; id < found->size(); ++id)
+                if ((*found)[id])
+                    ret.output += path + ": " + to_string(fdt::path(info.tree, id)) + "\n";
+    }
+
+    if (options.stats)
+        ret.output += path + ": " + stats(info) + "\n";
+
+    return ret;
+}
+} // namespace
+
+auto batch::requested(const int argc, char *argv[]) noexcept -> bool {
+    for (auto i = 1; i < argc; ++i) {
+        const auto arg = std::string_view(argv[i]);
+        for (auto &&option : REPORT_OPTIONS)
+            if (arg == option || (arg.starts_with(option) && '=' == arg[option.size()]))
+                return true;
+    }
+
+    return false;
+}
+
+auto batch::run(const options &value, const string_list &inputs) -> int {
+    const auto paths = collect_inputs(inputs);
+
+    file out;
+    file err;
+    out.open(stdout, QIODevice::WriteOnly);
+    err.open(stderr, QIODevice::WriteOnly);
+
+    if (paths.isEmpty()) {
+        err.write("no input files\n");
+        return 1;
+    }
+
+    auto future = QtConcurrent::mapped(paths, [&value](const string &path) { return process(value, path); });
+
+    // reports are written as soon as the ones before them are done
+    auto failed = false;
+    for (auto i = 0; i < paths.size(); ++i) {
+        const auto result = future.resultAt(i);
+        out.write(result.output.toUtf8());
+        out.flush();
+
+        if (!result.errors.isEmpty()) {
+            err.write(result.errors.toUtf8());
+            failed = true;
+        }
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <types.hpp>
+
+#include <optional>
+
+namespace batch {
+
+// headless reports, every input file is processed on the global thread pool and its
+// report is written to stdout in the order of the inputs
+struct options {
+    bool dump{false};
+    std::optional<string> query;  // absolute path of a node or a property
+    std::optional<string> search; // same matching as the quick search
+    bool stats{false};
+};
+
+// true when the command line asks for a report, checked before any application object exists
+auto requested(int argc, char *argv[]) noexcept -> bool;
+
+// inputs are files or directories, returns the process exit code
+auto run(const options &value, const string_list &inputs) -> int;
+
+} // namespace batch
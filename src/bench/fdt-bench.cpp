@@ -0,0 +1,269 @@
+#include <endian-conversions.hpp>
+#include <fdt/fdt-address-map.hpp>
+#include <fdt/fdt-cache.hpp>
+#include <fdt/fdt-generator.hpp>
+#include <fdt/fdt-header.hpp>
+#include <fdt/fdt-parser.hpp>
+#include <fdt/fdt-phandles.hpp>
+#include <fdt/fdt-tree.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// the same sink twice: through the virtual adapter and handed to the templated front-end
+struct null_generator : public iface_fdt_generator {
+    void begin_node(std::string_view) noexcept final { ++nodes; }
+    void end_node() noexcept final {}
+    void insert_property(const fdt_property &) noexcept final { ++properties; }
+    void deferred_node(std::string_view, const fdt_span &) noexcept final { ++nodes; }
+
+    u64 nodes{0};
+    u64 properties{0};
+};
+
+struct counting_generator {
+    void begin_node(std::string_view) noexcept { ++nodes; }
+    void end_node() noexcept {}
+    void insert_property(const fdt_property &) noexcept { ++properties; }
+    void deferred_node(std::string_view, const fdt_span &) noexcept { ++nodes; }
+
+    u64 nodes{0};
+    u64 properties{0};
+};
+
+class synthetic_blob {
+public:
+    void begin_node(std::string_view name) {
+        append_u32(m_struct, static_cast<u32>(fdt::token::begin_node));
+        append_padded(m_struct, name, name.size() + 1);
+    }
+
+    void end_node() {
+        append_u32(m_struct, static_cast<u32>(fdt::token::end_node));
+    }
+
+    void property(std::string_view name, std::string_view data) {
+        append_u32(m_struct, static_cast<u32>(fdt::token::property));
+        append_u32(m_struct, static_cast<u32>(data.size()));
+        append_u32(m_struct, string_offset(name));
+        append_padded(m_struct, data, data.size());
+    }
+
+    auto finish() -> std::string {
+        append_u32(m_struct, static_cast<u32>(fdt::token::end));
+
+        constexpr auto rsvmap_size = 16;
+        const auto off_dt_struct = static_cast<u32>(sizeof(fdt::header) + rsvmap_size);
+        const auto off_dt_strings = static_cast<u32>(off_dt_struct + m_struct.size());
+
+        std::string ret;
+        append_u32(ret, FDT_MAGIC_VALUE);
+        append_u32(ret, static_cast<u32>(off_dt_strings + m_strings.size()));
+        append_u32(ret, off_dt_struct);
+        append_u32(ret, off_dt_strings);
+        append_u32(ret, sizeof(fdt::header));
+        append_u32(ret, 17);
+        append_u32(ret, 16);
+        append_u32(ret, 0);
+        append_u32(ret, static_cast<u32>(m_strings.size()));
+        append_u32(ret, static_cast<u32>(m_struct.size()));
+        ret.append(rsvmap_size, '\0');
+        ret += m_struct;
+        ret += m_strings;
+        return ret;
+    }
+
+private:
+    static void append_u32(std::string &out, const u32 value) {
+        const auto be = convert(value);
+        out.append(reinterpret_cast<const char *>(&be), sizeof(be));
+    }
+
+    static void append_padded(std::string &out, std::string_view data, const std::size_t size) {
+        out.append(data);
+        out.append(size - data.size(), '\0');
+        out.append((4 - size % 4) % 4, '\0');
+    }
+
+    auto string_offset(std::string_view name) -> u32 {
+        auto [iter, inserted] = m_string_offsets.try_emplace(std::string(name), static_cast<u32>(m_strings.size()));
+        if (inserted) {
+            m_strings.append(name);
+            m_strings.push_back('\0');
+        }
+        return iter->second;
+    }
+
+    std::string m_struct;
+    std::string m_strings;
+    std::unordered_map<std::string, u32> m_string_offsets;
+};
+
+// <address size> with two cells each
+auto reg(const u64 address, const u64 size) -> std::string {
+    std::string ret;
+    for (auto &&value : {address >> 32, address, size >> 32, size}) {
+        const auto be = convert(static_cast<u32>(value));
+        ret.append(reinterpret_cast<const char *>(&be), sizeof(be));
+    }
+    return ret;
+}
+
+auto make_synthetic_blob(const u32 node_count) -> std::string {
+    using namespace std::string_view_literals;
+    constexpr auto devices_per_bus = 64u;
+
+    synthetic_blob blob;
+    blob.begin_node({});
+    blob.property("#address-cells", "\0\0\0\2"sv);
+    blob.property("#size-cells", "\0\0\0\2"sv);
+    blob.property("compatible", "vendor,synthetic-board\0"sv);
+
+    for (u32 bus = 0; bus * devices_per_bus < node_count; ++bus) {
+        blob.begin_node("bus@" + std::to_string(bus));
+        blob.property("compatible", "simple-bus\0"sv);
+        blob.property("#address-cells", "\0\0\0\2"sv);
+        blob.property("#size-cells", "\0\0\0\2"sv);
+        blob.property("ranges", {});
+
+        for (u32 device = 0; device < devices_per_bus && bus * devices_per_bus + device < node_count; ++device) {
+            blob.begin_node("device@" + std::to_string(device));
+            blob.property("compatible", "vendor,synthetic-device\0"sv);
+            blob.property("reg", reg(0x10000000ull + (u64{bus} * devices_per_bus + device) * 0x1000, 0x100));
+            blob.property("interrupts", "\0\0\0\0\0\0\0\x20\0\0\0\x04"sv);
+            blob.property("clocks", "\0\0\0\x01\0\0\0\x02"sv);
+            blob.property("status", "okay\0"sv);
+            blob.end_node();
+        }
+
+        blob.end_node();
+    }
+
+    blob.end_node();
+    return blob.finish();
+}
+
+auto read_file(const char *path) -> std::string {
+    std::ifstream stream(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+}
+
+void report(const std::string &name, const std::size_t bytes, const u64 nodes, const u64 properties, const std::chrono::duration<double> elapsed) {
+    const auto seconds = elapsed.count();
+    std::printf("%-48s %10.1f MB/s %14.0f nodes/s %14.0f properties/s\n",
+        name.c_str(),
+        static_cast<double>(bytes) / seconds / 1e6,
+        static_cast<double>(nodes) / seconds,
+        static_cast<double>(properties) / seconds);
+}
+
+void bench(const std::string &name, const std::string &blob, const int iterations) {
+    null_generator generator;
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto i = 0; i < iterations; ++i) {
+        fdt::name_table names;
+        fdt_parser parser(blob.data(), blob.size(), generator, names);
+        if (!parser.is_valid()) {
+            std::printf("%-48s invalid fdt\n", name.c_str());
+            return;
+        }
+    }
+    report(name + " [parser]", blob.size() * iterations, generator.nodes, generator.properties, std::chrono::steady_clock::now() - start);
+
+    counting_generator counter;
+
+    start = std::chrono::steady_clock::now();
+    for (auto i = 0; i < iterations; ++i) {
+        fdt::name_table names;
+        basic_fdt_parser parser(blob.data(), blob.size(), counter, names);
+    }
+    report(name + " [parser, template]", blob.size() * iterations, counter.nodes, counter.properties, std::chrono::steady_clock::now() - start);
+
+    u64 nodes = 0;
+    u64 properties = 0;
+
+    start = std::chrono::steady_clock::now();
+    for (auto i = 0; i < iterations; ++i) {
+        const auto tree = fdt::parse_tree({blob, nullptr});
+        nodes += tree->nodes.size();
+        properties += tree->properties.size();
+    }
+    report(name + " [tree]", blob.size() * iterations, nodes, properties, std::chrono::steady_clock::now() - start);
+
+    // time to first paint with lazy loading: the root level only
+    nodes = 0;
+    properties = 0;
+
+    start = std::chrono::steady_clock::now();
+    for (auto i = 0; i < iterations; ++i) {
+        const auto tree = fdt::parse_tree({blob, nullptr}, fdt::parse_mode::lazy);
+        nodes += tree->nodes.size();
+        properties += tree->properties.size();
+    }
+    report(name + " [lazy tree]", blob.size() * iterations, nodes, properties, std::chrono::steady_clock::now() - start);
+
+    // parsing plus every reg translated and checked for overlaps, regions count as nodes
+    u64 regions = 0;
+
+    start = std::chrono::steady_clock::now();
+    for (auto i = 0; i < iterations; ++i) {
+        auto tree = fdt::parse_tree({blob, nullptr}).value();
+        fdt::phandle_index phandles;
+        phandles.update(tree);
+        regions += fdt::build_address_map(tree, phandles).regions.regions().size();
+    }
+    report(name + " [tree + address map]", blob.size() * iterations, regions, 0, std::chrono::steady_clock::now() - start);
+
+    // reopening an unchanged file from its index, see fdt-cache.hpp
+    const fdt::cache_key key{blob.size(), 0, fdt::parse_mode::full};
+    const auto index = fdt::save_index(fdt::parse_tree({blob, nullptr}).value(), key);
+    if (!index)
+        return;
+
+    nodes = 0;
+    properties = 0;
+
+    start = std::chrono::steady_clock::now();
+    for (auto i = 0; i < iterations; ++i) {
+        const auto tree = fdt::load_index(index.value(), {blob, nullptr}, key);
+        nodes += tree->nodes.size();
+        properties += tree->properties.size();
+    }
+    report(name + " [cached tree]", blob.size() * iterations, nodes, properties, std::chrono::steady_clock::now() - start);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    auto iterations = 100;
+    std::vector<const char *> files;
+
+    for (auto i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if ((arg == "-n" || arg == "--iterations") && i + 1 < argc)
+            iterations = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "-h" || arg == "--help") {
+            std::printf("Usage: %s [-n iterations] [file...]\n", argv[0]);
+            return 0;
+        } else
+            files.emplace_back(argv[i]);
+    }
+
+    for (auto &&nodes : {1000u, 10000u, 100000u})
+        bench("synthetic " + std::to_string(nodes) + " nodes", make_synthetic_blob(nodes), iterations);
+
+    for (auto &&path : files)
+        bench(path, read_file(path), iterations);
+
+    return 0;
+}
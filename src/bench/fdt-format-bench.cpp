@@ -0,0 +1,76 @@
+#include <fdt/fdt-format.hpp>
+#include <integer-types.hpp>
+
+#include <QByteArray>
+#include <QString>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+namespace {
+constexpr auto BINARY_PREVIEW_LIMIT = 256;
+
+// the per byte formatter the property view used before fdt::format_cells
+QString legacy_present_u32be(const QByteArray &data) {
+    QString ret;
+
+    auto array = reinterpret_cast<u8 *>(const_cast<char *>(data.data()));
+    for (auto i = 0; i < data.size(); ++i) {
+        ret += "0x" + QString::number(array[i], 16).rightJustified(2, '0').toUpper() + " ";
+        if (i == BINARY_PREVIEW_LIMIT) {
+            ret += "... ";
+            break;
+        }
+    }
+    ret.remove(ret.size() - 1, 1);
+
+    return ret;
+}
+
+QString present_cells(const std::string_view data, const fdt::cell_format format) {
+    QString ret(static_cast<qsizetype>(fdt::formatted_size(data.size(), format, BINARY_PREVIEW_LIMIT)), Qt::Uninitialized);
+    const auto begin = reinterpret_cast<char16_t *>(ret.data());
+    ret.truncate(fdt::format_cells(data, format, begin, BINARY_PREVIEW_LIMIT) - begin);
+    return ret;
+}
+
+template <typename function>
+void bench(const char *name, const std::size_t size, const int iterations, function &&format) {
+    std::string data(size, '\0');
+    for (std::size_t i = 0; i < size; ++i)
+        data[i] = static_cast<char>(i * 37);
+
+    std::size_t chars = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (auto i = 0; i < iterations; ++i)
+        chars += format(data).size();
+    const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("%-24s %6zu bytes %12.0f properties/s %10.1f MB/s (%zu chars)\n",
+        name, size,
+        iterations / seconds,
+        static_cast<double>(std::min<std::size_t>(size, BINARY_PREVIEW_LIMIT)) * iterations / seconds / 1e6,
+        chars / iterations);
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+    const auto iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 100000;
+
+    for (auto &&size : {4u, 16u, 64u, 256u, 4096u}) {
+        bench("legacy present_u32be", size, iterations, [](const std::string &data) {
+            return legacy_present_u32be(QByteArray::fromRawData(data.data(), data.size()));
+        });
+        bench("format_cells u32", size, iterations, [](const std::string &data) {
+            return present_cells(data, fdt::cell_format::u32);
+        });
+        bench("format_cells bytes", size, iterations, [](const std::string &data) {
+            return present_cells(data, fdt::cell_format::bytes);
+        });
+    }
+
+    return 0;
+}
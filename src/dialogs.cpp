@@ -3,6 +3,7 @@
 #include <types.hpp>
 
 #include <QFileDialog>
+#include <QInputDialog>
 #include <QMessageBox>
 #include <QObject>
 
@@ -35,6 +36,34 @@ void fdt::open_directory_dialog(widget *parent, path_callable &&callable) {
             callable(dir);
 }
 
+void fdt::open_overlays_dialog(widget *parent, paths_callable &&callable) {
+    const string_list filters{
+        parent->tr("FDT overlay files (*.dtbo)"),
+        parent->tr("Any files (*.*)"),
+    };
+
+    QFileDialog dialog(parent);
+    dialog.setFileMode(QFileDialog::ExistingFiles);
+    dialog.setWindowTitle(parent->tr("Apply Overlays"));
+    dialog.setDirectory(QDir::homePath());
+    dialog.setNameFilter(filters.join(";;"));
+    if (dialog.exec() == QDialog::Accepted && !dialog.selectedFiles().isEmpty())
+        callable(dialog.selectedFiles());
+}
+
+void fdt::compare_with_dialog(widget *parent, const string_list &names, choice_callable &&callable) {
+    auto accepted = false;
+    const auto name = QInputDialog::getItem(parent, parent->tr("Compare With"), parent->tr("Device tree:"), names, 0, false, &accepted);
+    if (accepted && names.contains(name))
+        callable(static_cast<int>(names.indexOf(name)));
+}
+
+void fdt::save_blob_dialog(widget *parent, const string &hint, path_callable &&callable) {
+    const auto path = QFileDialog::getSaveFileName(parent, parent->tr("Export Blob"), QDir::home().filePath(hint), parent->tr("FDT file (*.dtb)"));
+    if (!path.isEmpty())
+        callable(path);
+}
+
 auto dialogs::ask_already_opened(widget *parent) noexcept -> bool {
     return QMessageBox::question(parent, parent->tr("Question"), parent->tr("File is already opened, do you want to reload?"), QMessageBox::Yes | QMessageBox::No) !=
         QMessageBox::Yes;
@@ -44,6 +73,20 @@ auto dialogs::warn_invalid_fdt(const string &filename, widget *parent) noexcept
     QMessageBox::critical(parent, parent->tr("Invalid FDT format"), parent->tr("Unable to parse %1").arg(filename));
 }
 
+auto dialogs::warn_invalid_fdt(const string_list &filenames, widget *parent) noexcept -> void {
+    QMessageBox box(QMessageBox::Critical, parent->tr("Invalid FDT format"), parent->tr("Unable to parse %1 file(s)").arg(filenames.size()), QMessageBox::Ok, parent);
+    box.setDetailedText(filenames.join("\n"));
+    box.exec();
+}
+
+auto dialogs::warn_overlay_failed(const string &reason, widget *parent) noexcept -> void {
+    QMessageBox::critical(parent, parent->tr("Unable to apply overlays"), reason);
+}
+
+auto dialogs::warn_export_failed(const string &filename, widget *parent) noexcept -> void {
+    QMessageBox::critical(parent, parent->tr("Export failed"), parent->tr("Unable to write %1").arg(filename));
+}
+
 auto fdt::export_property_file_dialog(widget *parent, const QByteArray &data, const QString &hint) -> void {
 #if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
     QFileDialog::saveFileContent(data, hint);
@@ -10,14 +10,22 @@
 namespace dialogs {
 auto ask_already_opened(widget *parent) noexcept -> bool;
 auto warn_invalid_fdt(const string &filename, widget *parent) noexcept -> void;
+auto warn_invalid_fdt(const string_list &filenames, widget *parent) noexcept -> void;
+auto warn_overlay_failed(const string &reason, widget *parent) noexcept -> void;
+auto warn_export_failed(const string &filename, widget *parent) noexcept -> void;
 } // namespace dialogs
 
 namespace fdt {
 
 using path_callable = std::function<void(const string &path)>;
+using paths_callable = std::function<void(const string_list &paths)>;
+using choice_callable = std::function<void(int choice)>;
 
 void open_file_dialog(widget *parent, path_callable &&callable);
 void open_directory_dialog(widget *parent, path_callable &&callable);
+void open_overlays_dialog(widget *parent, paths_callable &&callable);
+void compare_with_dialog(widget *parent, const string_list &names, choice_callable &&callable);
+void save_blob_dialog(widget *parent, const string &hint, path_callable &&callable);
 auto export_property_file_dialog(widget *parent, const QByteArray &data, const QString &hint) -> void;
 
 } // namespace fdt
@@ -1,9 +1,13 @@
 #pragma once
 
-#include <types.hpp>
+#include <integer-types.hpp>
 
+#include <algorithm>
+#include <array>
 #include <bit>
+#include <concepts>
 #include <cstring>
+#include <span>
 
 template <std::integral T>
 constexpr T byteswap(T value) noexcept {
@@ -31,3 +35,11 @@ constexpr type read_data_32be(input_data *input) noexcept {
         data[i] = convert<u32>(data[i]);
     return container;
 }
+
+// converts a whole array of big-endian cells, out holds as many cells as are read
+inline void read_cells_32be(const char *input, std::span<u32> out) noexcept {
+    std::memcpy(out.data(), input, out.size_bytes());
+    if constexpr (std::endian::native == std::endian::little)
+        for (auto &&value : out)
+            value = byteswap(value);
+}
@@ -0,0 +1,239 @@
+#include "fdt-address-map.hpp"
+
+#include <endian-conversions.hpp>
+#include <fdt/fdt-cells.hpp>
+#include <fdt/fdt-header.hpp>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <optional>
+#include <unordered_map>
+
+namespace {
+using namespace std::string_view_literals;
+
+// addresses wider than 64 bits (PCI) keep their low cells, the high cell holds flags
+auto read_address(std::span<const u32> cells) noexcept -> u64 {
+    if (cells.empty())
+        return 0;
+
+    if (1 == cells.size())
+        return cells.back();
+
+    return (u64{cells[cells.size() - 2]} << 32) | cells.back();
+}
+
+auto find_own(const fdt::tree &value, const fdt::index node, const fdt::known_name name) noexcept -> const fdt::property_entry * {
+    for (auto &&child : value.children(value.nodes[node]))
+        if (fdt::entry_type::property == child.type && fdt::id(name) == value.properties[child.value].name)
+            return &value.properties[child.value];
+
+    return nullptr;
+}
+
+auto read_cells(std::string_view data) -> std::vector<u32> {
+    std::vector<u32> ret(data.size() / 4);
+    read_cells_32be(data.data(), ret);
+    return ret;
+}
+
+// bus addresses up to the root, the windows of every bus are decoded once
+class translator {
+public:
+    translator(fdt::tree &value, const fdt::phandle_index &phandles)
+            : m_tree(value)
+            , m_phandles(phandles) {}
+
+    auto translate(const fdt::index node, u64 address) -> std::optional<u64> {
+        for (auto bus = m_tree.nodes[node].parent; fdt::npos != bus && fdt::npos != m_tree.nodes[bus].parent; bus = m_tree.nodes[bus].parent) {
+            const auto &windows = windows_of(bus);
+            if (!windows)
+                return {}; // no ranges, the bus is not memory mapped (i2c, spi, ...)
+
+            if (windows->empty())
+                continue; // empty ranges, identity mapping
+
+            const auto iter = std::ranges::find_if(*windows, [address](auto &&window) {
+                return window.child <= address && address - window.child < window.size;
+            });
+
+            if (windows->end() == iter)
+                return {};
+
+            address = iter->parent + (address - iter->child);
+        }
+
+        return address;
+    }
+
+private:
+    struct window {
+        u64 child{0};
+        u64 parent{0};
+        u64 size{0};
+    };
+
+    auto windows_of(const fdt::index bus) -> const std::optional<std::vector<window>> & {
+        if (const auto iter = m_windows.find(bus); m_windows.end() != iter)
+            return iter->second;
+
+        auto &ret = m_windows[bus];
+        const auto ranges = find_own(m_tree, bus, fdt::known_name::ranges);
+        if (nullptr == ranges)
+            return ret;
+
+        ret.emplace();
+        const auto &plan = fdt::resolve_cells(m_tree, m_phandles, bus);
+        const auto group = fdt::entry_cells(plan, fdt::id(fdt::known_name::ranges));
+        const auto cells = read_cells(ranges->data);
+        if (0 == group || cells.size() % group)
+            return ret;
+
+        for (std::size_t i = 0; i < cells.size(); i += group) {
+            const auto entry = std::span(cells).subspan(i, group);
+            ret->push_back({
+                .child = read_address(entry.first(plan.child_address)),
+                .parent = read_address(entry.subspan(plan.child_address, plan.address)),
+                .size = read_address(entry.last(plan.child_size)),
+            });
+        }
+
+        return ret;
+    }
+
+private:
+    fdt::tree &m_tree;
+    const fdt::phandle_index &m_phandles;
+    std::unordered_map<fdt::index, std::optional<std::vector<window>>> m_windows;
+};
+
+auto is_ancestor(const fdt::tree &value, const fdt::index ancestor, fdt::index node) noexcept -> bool {
+    for (; fdt::npos != node; node = value.nodes[node].parent)
+        if (node == ancestor)
+            return true;
+
+    return false;
+}
+
+// memory is expected to contain the reservations carved out of it, and a node with reg
+// often hands parts of its window to its children
+auto expected(const fdt::tree &value, const fdt::region &lhs, const fdt::region &rhs) noexcept -> bool {
+    const auto reserved = [](auto kind) { return fdt::region_kind::reserved_memory == kind || fdt::region_kind::memreserve == kind; };
+    if ((fdt::region_kind::memory == lhs.kind && reserved(rhs.kind)) || (fdt::region_kind::memory == rhs.kind && reserved(lhs.kind)))
+        return true;
+
+    if (fdt::npos == lhs.node || fdt::npos == rhs.node)
+        return false;
+
+    return lhs.node == rhs.node || is_ancestor(value, lhs.node, rhs.node) || is_ancestor(value, rhs.node, lhs.node);
+}
+} // namespace
+
+auto fdt::read_reservations(std::string_view blob) -> std::vector<reservation> {
+    std::vector<reservation> ret;
+    if (blob.size() < sizeof(header))
+        return ret;
+
+    const auto source = read_data_32be<header>(blob.data());
+    if (FDT_MAGIC_VALUE != source.magic)
+        return ret;
+
+    for (u64 offset = source.off_mem_rsvmap; offset + 2 * sizeof(u64) <= blob.size(); offset += 2 * sizeof(u64)) {
+        const auto entry = read_data_32be<std::array<u32, 4>>(blob.data() + offset);
+        const reservation value{(u64{entry[0]} << 32) | entry[1], (u64{entry[2]} << 32) | entry[3]};
+        if (0 == value.address && 0 == value.size)
+            break;
+
+        ret.emplace_back(value);
+    }
+
+    return ret;
+}
+
+fdt::interval_tree::interval_tree(std::vector<region> &&values)
+        : m_regions(std::move(values))
+        , m_highest(m_regions.size()) {
+    std::ranges::sort(m_regions, [](auto &&lhs, auto &&rhs) {
+        return lhs.first < rhs.first || (lhs.first == rhs.first && lhs.last < rhs.last);
+    });
+
+    build(0, m_regions.size());
+}
+
+auto fdt::interval_tree::build(const std::size_t begin, const std::size_t end) -> u64 {
+    if (begin >= end)
+        return 0;
+
+    const auto middle = begin + (end - begin) / 2;
+    m_highest[middle] = std::max({m_regions[middle].last, build(begin, middle), build(middle + 1, end)});
+    return m_highest[middle];
+}
+
+auto fdt::build_address_map(tree &value, const phandle_index &phandles) -> address_map {
+    address_map ret;
+    ret.nodes = value.nodes.size();
+
+    std::vector<region> regions;
+    if (!value.blobs.empty()) {
+        const auto reservations = read_reservations(value.blobs.front().data);
+        for (u32 i = 0; i < reservations.size(); ++i)
+            if (reservations[i].size)
+                regions.push_back({reservations[i].address, reservations[i].address + std::min(reservations[i].size - 1, std::numeric_limits<u64>::max() - reservations[i].address), region_kind::memreserve, npos, i});
+    }
+
+    const auto reserved_memory = find_path(value, "/reserved-memory");
+    const auto device_type = value.names.find("device_type");
+
+    // nodes are stored before their descendants, embedded blobs mark everything below them
+    std::vector<u8> embedded(value.nodes.size(), 0);
+    translator addresses(value, phandles);
+
+    for (index node = 0; node < value.nodes.size(); ++node) {
+        const auto &entry = value.nodes[node];
+        embedded[node] = entry.embedded || (npos != entry.parent && embedded[entry.parent]);
+
+        const auto reg = find_own(value, node, known_name::reg);
+        if (embedded[node] || nullptr == reg || npos == entry.parent)
+            continue;
+
+        auto kind = region_kind::device;
+        if (reserved_memory == entry.parent)
+            kind = region_kind::reserved_memory;
+        else if (0 == entry.parent && (entry.name == "memory"sv || entry.name.starts_with("memory@"sv)))
+            kind = region_kind::memory;
+        else if (device_type)
+            for (auto &&child : value.children(entry))
+                if (entry_type::property == child.type && device_type.value() == value.properties[child.value].name && value.properties[child.value].data.starts_with("memory"sv))
+                    kind = region_kind::memory;
+
+        const auto plan = resolve_cells(value, phandles, node);
+        const auto group = entry_cells(plan, id(known_name::reg));
+        const auto cells = read_cells(reg->data);
+        if (0 == group || 0 == plan.size || cells.size() % group)
+            continue;
+
+        for (std::size_t i = 0; i < cells.size(); i += group) {
+            const auto values = std::span(cells).subspan(i, group);
+            const auto size = read_address(values.last(plan.size));
+            const auto address = addresses.translate(node, read_address(values.first(plan.address)));
+            if (0 == size || !address)
+                continue;
+
+            const auto last = address.value() + std::min(size - 1, std::numeric_limits<u64>::max() - address.value());
+            regions.push_back({address.value(), last, kind, node, static_cast<u32>(i / group)});
+        }
+    }
+
+    ret.regions = interval_tree(std::move(regions));
+
+    // every pair is reported once, by the region that starts first
+    const auto sorted = ret.regions.regions();
+    for (u32 i = 0; i < sorted.size(); ++i)
+        ret.regions.overlapping(sorted[i].first, sorted[i].last, [&](const u32 other) {
+            if (other > i && !expected(value, sorted[i], sorted[other]))
+                ret.overlaps.emplace_back(i, other);
+        });
+
+    return ret;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <fdt/fdt-phandles.hpp>
+#include <fdt/fdt-tree.hpp>
+#include <integer-types.hpp>
+
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace fdt {
+
+// an entry of the memory reservation block, /memreserve/ in DTS
+struct reservation {
+    u64 address{0};
+    u64 size{0};
+};
+
+// entries up to the terminating empty one, a block running past the blob is cut
+auto read_reservations(std::string_view blob) -> std::vector<reservation>;
+
+enum class region_kind : u8 {
+    device,          // reg of a node, translated through the ranges of its buses
+    memory,          // reg of a /memory node
+    reserved_memory, // reg of a /reserved-memory child
+    memreserve,      // entry of the reservation block
+};
+
+struct region {
+    u64 first{0};
+    u64 last{0}; // inclusive, a region can end at the top of the address space
+    region_kind kind{region_kind::device};
+    index node{npos}; // npos for memreserve entries
+    u32 entry{0};     // within reg or the reservation block
+};
+
+// static interval tree: regions sorted by start, every middle element of a range keeps the
+// highest end below it; built in O(n log n), a query costs O(log n + matches)
+class interval_tree {
+public:
+    interval_tree() = default;
+    explicit interval_tree(std::vector<region> &&values);
+
+    template <typename function>
+    void overlapping(const u64 first, const u64 last, function &&found) const {
+        visit(0, m_regions.size(), first, last, found);
+    }
+
+    auto regions() const noexcept -> std::span<const region> { return m_regions; }
+
+private:
+    auto build(std::size_t begin, std::size_t end) -> u64;
+
+    template <typename function>
+    void visit(const std::size_t begin, const std::size_t end, const u64 first, const u64 last, function &found) const {
+        if (begin >= end)
+            return;
+
+        const auto middle = begin + (end - begin) / 2;
+        if (m_highest[middle] < first)
+            return;
+
+        visit(begin, middle, first, last, found);
+
+        // everything right of the middle starts even later
+        const auto &value = m_regions[middle];
+        if (value.first > last)
+            return;
+
+        if (value.last >= first)
+            found(static_cast<u32>(middle));
+
+        visit(middle + 1, end, first, last, found);
+    }
+
+private:
+    std::vector<region> m_regions;
+    std::vector<u64> m_highest;
+};
+
+// physical address map of a tree; ranges of memory overlapping the reservations inside
+// it, and nodes nested in their ancestor's window, are expected and not reported
+struct address_map {
+    interval_tree regions;
+    std::vector<std::pair<u32, u32>> overlaps; // indexes into regions.regions()
+    std::size_t nodes{0};                      // size of the tree the map was built from
+};
+
+// collects every translatable reg entry and the reservation block of the first blob;
+// nodes of embedded blobs live in their own address space and are left out
+auto build_address_map(tree &value, const phandle_index &phandles) -> address_map;
+
+} // namespace fdt
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <memory>
+#include <string_view>
+
+namespace fdt {
+
+struct blob {
+    std::string_view data;
+    std::shared_ptr<const void> owner; // keeps the mapping or buffer behind data alive
+};
+
+} // namespace fdt
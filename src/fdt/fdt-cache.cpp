@@ -0,0 +1,362 @@
+#include "fdt-cache.hpp"
+
+#include <endian-conversions.hpp>
+#include <fdt/fdt-header.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace {
+constexpr std::array<char, 8> INDEX_MAGIC{'F', 'D', 'T', 'I', 'N', 'D', 'E', 'X'};
+constexpr auto INDEX_VERSION = 4u; // 2: more known names, 3: string lists under string names, 4: portable fingerprint
+
+// offset of a view that is not part of the blob, see offset_in
+constexpr auto NO_OFFSET = std::numeric_limits<u32>::max();
+constexpr auto NODE_EMBEDDED = 1u;
+constexpr auto NODE_INTERNED_NAME = 2u; // the name is an id of the name table, not an offset
+constexpr auto ROW_PROPERTY = 1u << 31;
+
+// the index is read back by the same build, records are stored in native byte order
+struct index_header {
+    std::array<char, 8> magic{INDEX_MAGIC};
+    u32 version{INDEX_VERSION};
+    u32 mode{0};
+    u64 size{0};
+    i64 modified{0};
+    u64 fingerprint{0};
+    u32 names{0};
+    u32 name_bytes{0};
+    u32 nodes{0};
+    u32 properties{0};
+    u32 rows{0};
+    u32 deferred{0};
+    u32 hashes{0};
+    u32 reserved{0};
+};
+
+// parents and rows within the parent are not stored, load_index takes them from the rows
+struct node_record {
+    u32 name{0};
+    u32 name_size{0};
+    u32 rows_begin{0};
+    u32 row_count{0};
+    u32 deferred{0};
+    u32 flags{0};
+};
+
+struct property_record {
+    u32 name{0};
+    u32 data{0};
+    u32 data_size{0};
+};
+
+struct deferred_record {
+    u32 fdt{0};
+    u32 begin{0};
+    u32 end{0};
+    u32 root{0};
+};
+
+// FNV-1a over the whole blob: an edit that keeps size and mtime may touch only the
+// structure block, and the value has to be the same for every build reading the index
+auto fingerprint(std::string_view data) -> std::optional<u64> {
+    if (data.size() < sizeof(fdt::header))
+        return {};
+
+    auto ret = u64{0xcbf29ce484222325};
+    for (auto &&value : data) {
+        ret ^= static_cast<u8>(value);
+        ret *= u64{0x100000001b3};
+    }
+
+    return ret;
+}
+
+// views keep their position even when empty, the writer reads the name offset before a value
+auto offset_in(std::string_view blob, const char *data, const std::size_t size) noexcept -> std::optional<u32> {
+    if (nullptr == data)
+        return NO_OFFSET;
+
+    if (data < blob.data() || data > blob.data() + blob.size() || size > static_cast<std::size_t>(blob.data() + blob.size() - data))
+        return {};
+
+    return static_cast<u32>(data - blob.data());
+}
+
+auto view_in(std::string_view blob, const u32 offset, const u32 size) noexcept -> std::optional<std::string_view> {
+    if (NO_OFFSET == offset)
+        return 0 == size ? std::optional<std::string_view>{std::string_view{}} : std::nullopt;
+
+    if (offset > blob.size() || size > blob.size() - offset)
+        return {};
+
+    return std::string_view(blob.data() + offset, size);
+}
+
+template <typename type>
+void append(std::string &out, const type &value) {
+    out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <typename type>
+void append(std::string &out, const std::vector<type> &values) {
+    out.append(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(type));
+}
+
+// sections are consumed in the order save_index wrote them
+class index_reader {
+public:
+    explicit index_reader(std::string_view data)
+            : m_data(data) {}
+
+    template <typename type>
+    auto read(std::vector<type> &out, const std::size_t count) -> bool {
+        if (count > (m_data.size() - m_position) / sizeof(type))
+            return false;
+
+        out.resize(count);
+        std::memcpy(out.data(), m_data.data() + m_position, count * sizeof(type));
+        m_position += count * sizeof(type);
+        return true;
+    }
+
+    auto read(const std::size_t size) -> std::optional<std::string_view> {
+        if (size > m_data.size() - m_position)
+            return {};
+
+        m_position += size;
+        return m_data.substr(m_position - size, size);
+    }
+
+    auto consumed() const noexcept -> bool {
+        return m_position == m_data.size();
+    }
+
+private:
+    std::string_view m_data;
+    std::size_t m_position{0};
+};
+
+} // namespace
+
+auto fdt::save_index(const tree &value, const cache_key &key) -> std::optional<std::string> {
+    if (1 != value.blobs.size() || value.blobs.front().data.size() >= NO_OFFSET)
+        return {};
+
+    const auto blob = value.blobs.front().data;
+    const auto print = fingerprint(blob);
+    if (!print || value.rows.size() >= ROW_PROPERTY)
+        return {};
+
+    index_header header;
+    header.mode = static_cast<u32>(key.mode);
+    header.size = key.size;
+    header.modified = key.modified;
+    header.fingerprint = print.value();
+    header.names = static_cast<u32>(value.names.size());
+    header.nodes = static_cast<u32>(value.nodes.size());
+    header.properties = static_cast<u32>(value.properties.size());
+    header.rows = static_cast<u32>(value.rows.size());
+    header.deferred = static_cast<u32>(value.deferred.size());
+    header.hashes = static_cast<u32>(value.hashes.size());
+
+    std::vector<u32> name_offsets;
+    name_offsets.reserve(value.names.size() + 1);
+    name_offsets.emplace_back(0);
+    std::string name_data;
+    for (name_id id = 0; id < value.names.size(); ++id) {
+        name_data.append(value.names.name(id));
+        name_offsets.emplace_back(static_cast<u32>(name_data.size()));
+    }
+    header.name_bytes = static_cast<u32>(name_data.size());
+
+    std::vector<node_record> nodes;
+    nodes.reserve(value.nodes.size());
+    for (auto &&node : value.nodes) {
+        node_record record{
+            .rows_begin = node.rows_begin,
+            .row_count = node.row_count,
+            .deferred = node.deferred,
+            .flags = node.embedded ? NODE_EMBEDDED : 0,
+        };
+
+        // names outside the blob are literals of the parser, all of them known names
+        if (const auto offset = offset_in(blob, node.name.data(), node.name.size())) {
+            record.name = offset.value();
+            record.name_size = static_cast<u32>(node.name.size());
+        } else if (const auto id = value.names.find(node.name)) {
+            record.name = id.value();
+            record.flags |= NODE_INTERNED_NAME;
+        } else
+            return {};
+
+        nodes.emplace_back(record);
+    }
+
+    std::vector<property_record> properties;
+    std::vector<u8> types;
+    properties.reserve(value.properties.size());
+    types.reserve(value.properties.size());
+    for (auto &&property : value.properties) {
+        const auto offset = offset_in(blob, property.data.data(), property.data.size());
+        if (!offset)
+            return {};
+
+        properties.push_back({property.name, offset.value(), static_cast<u32>(property.data.size())});
+        types.emplace_back(static_cast<u8>(property.type));
+    }
+
+    std::vector<u32> rows;
+    rows.reserve(value.rows.size());
+    for (auto &&row : value.rows)
+        rows.emplace_back(row.value | (entry_type::property == row.type ? ROW_PROPERTY : 0));
+
+    std::vector<deferred_record> deferred;
+    deferred.reserve(value.deferred.size());
+    for (auto &&span : value.deferred) {
+        const auto offset = offset_in(blob, span.fdt, span.end);
+        if (!offset || NO_OFFSET == offset.value())
+            return {};
+
+        deferred.push_back({offset.value(), span.begin, span.end, span.root ? 1u : 0u});
+    }
+
+    std::string ret;
+    ret.reserve(sizeof(header) + value.hashes.size() * sizeof(u64) + name_offsets.size() * sizeof(u32) + nodes.size() * sizeof(node_record) +
+                properties.size() * (sizeof(property_record) + 1) + rows.size() * sizeof(u32) + deferred.size() * sizeof(deferred_record) + name_data.size());
+
+    // 64-bit hashes first, every later section only needs 4-byte alignment
+    append(ret, header);
+    append(ret, value.hashes);
+    append(ret, name_offsets);
+    append(ret, nodes);
+    append(ret, properties);
+    append(ret, rows);
+    append(ret, deferred);
+    append(ret, types);
+    ret.append(name_data);
+    return ret;
+}
+
+auto fdt::load_index(std::string_view data, const blob &source, const cache_key &key) -> std::optional<tree> {
+    index_reader reader(data);
+
+    std::vector<index_header> header;
+    if (!reader.read(header, 1))
+        return {};
+
+    const auto &head = header.front();
+    if (INDEX_MAGIC != head.magic || INDEX_VERSION != head.version || static_cast<u32>(key.mode) != head.mode ||
+        key.size != head.size || key.modified != head.modified || source.data.size() != key.size)
+        return {};
+
+    if (const auto print = fingerprint(source.data); !print || print.value() != head.fingerprint)
+        return {};
+
+    tree ret;
+    std::vector<u32> name_offsets;
+    std::vector<node_record> nodes;
+    std::vector<property_record> properties;
+    std::vector<u32> rows;
+    std::vector<deferred_record> deferred;
+    std::vector<u8> types;
+
+    if (!reader.read(ret.hashes, head.hashes) || !reader.read(name_offsets, std::size_t{head.names} + 1) ||
+        !reader.read(nodes, head.nodes) || !reader.read(properties, head.properties) ||
+        !reader.read(rows, head.rows) || !reader.read(deferred, head.deferred) || !reader.read(types, head.properties))
+        return {};
+
+    const auto name_data = reader.read(head.name_bytes);
+    if (!name_data || !reader.consumed() || (0 != head.hashes && head.hashes != head.nodes))
+        return {};
+
+    // the table interns the known names first, every other id has to come out the same
+    for (name_id id = 0; id < head.names; ++id) {
+        const auto begin = name_offsets[id];
+        const auto end = name_offsets[id + 1];
+        if (begin > end || end > name_data->size() || id != ret.names.intern(name_data->substr(begin, end - begin)))
+            return {};
+    }
+
+    if (ret.names.size() != head.names)
+        return {};
+
+    const auto blob = source.data;
+    ret.blobs.emplace_back(source);
+
+    ret.nodes.reserve(nodes.size());
+    for (auto &&record : nodes) {
+        if (record.rows_begin > head.rows ||
+            record.row_count > head.rows - record.rows_begin || (npos != record.deferred && record.deferred >= head.deferred))
+            return {};
+
+        std::optional<std::string_view> name;
+        if (record.flags & NODE_INTERNED_NAME) {
+            if (record.name < head.names)
+                name = ret.names.name(record.name);
+        } else
+            name = view_in(blob, record.name, record.name_size);
+
+        if (!name)
+            return {};
+
+        ret.nodes.push_back({
+            .name = name.value(),
+            .rows_begin = record.rows_begin,
+            .row_count = record.row_count,
+            .deferred = record.deferred,
+            .embedded = 0 != (record.flags & NODE_EMBEDDED),
+        });
+    }
+
+    ret.properties.reserve(properties.size());
+    for (std::size_t i = 0; i < properties.size(); ++i) {
+        const auto &record = properties[i];
+        const auto data = view_in(blob, record.data, record.data_size);
+        if (!data || record.name >= head.names || types[i] > static_cast<u8>(property_type::multiline))
+            return {};
+
+        ret.properties.push_back({.name = record.name, .type = static_cast<property_type>(types[i]), .data = data.value()});
+    }
+
+    ret.rows.reserve(rows.size());
+    for (auto &&row : rows) {
+        const auto type = (row & ROW_PROPERTY) ? entry_type::property : entry_type::node;
+        const auto value = row & ~ROW_PROPERTY;
+        if (value >= (entry_type::property == type ? head.properties : head.nodes))
+            return {};
+
+        ret.rows.push_back({type, value});
+    }
+
+    // every entry but the root belongs to exactly one node, which the rows tell
+    for (index id = 0; id < ret.nodes.size(); ++id) {
+        const auto &node = ret.nodes[id];
+        for (u32 row = 0; row < node.row_count; ++row) {
+            const auto child = ret.rows[node.rows_begin + row];
+            auto &parent = entry_type::property == child.type ? ret.properties[child.value].node : ret.nodes[child.value].parent;
+            if (npos != parent || (entry_type::node == child.type && 0 == child.value))
+                return {};
+
+            parent = id;
+            (entry_type::property == child.type ? ret.properties[child.value].row : ret.nodes[child.value].row) = row;
+        }
+    }
+
+    if (std::ranges::any_of(ret.properties, [](auto &&property) { return npos == property.node; }) ||
+        std::ranges::count_if(ret.nodes, [](auto &&node) { return npos == node.parent; }) > 1)
+        return {};
+
+    ret.deferred.reserve(deferred.size());
+    for (auto &&record : deferred) {
+        if (record.fdt > blob.size() || record.begin > record.end || record.end > blob.size() - record.fdt)
+            return {};
+
+        ret.deferred.push_back({.fdt = blob.data() + record.fdt, .begin = record.begin, .end = record.end, .root = 0 != record.root});
+    }
+
+    return ret;
+}
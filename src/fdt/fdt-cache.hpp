@@ -0,0 +1,29 @@
+#pragma once
+
+#include <fdt/fdt-blob.hpp>
+#include <fdt/fdt-tree.hpp>
+#include <integer-types.hpp>
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace fdt {
+
+// what an index was built from, any difference means the file has to be parsed again
+struct cache_key {
+    u64 size{0};
+    i64 modified{0}; // modification time of the file, in any fixed unit
+    parse_mode mode{parse_mode::full};
+};
+
+// flat image of a parsed tree: node and property tables, rows, deferred spans, subtree
+// hashes and interned names; data stays in the file and is stored as offsets, so trees
+// that reference other blobs (merged overlays) have no index
+auto save_index(const tree &value, const cache_key &key) -> std::optional<std::string>;
+
+// rebuilds the tree over the same file without parsing it; besides the key the header
+// and strings block of the blob have to match, a damaged index is rejected as a whole
+auto load_index(std::string_view data, const blob &source, const cache_key &key) -> std::optional<tree>;
+
+} // namespace fdt
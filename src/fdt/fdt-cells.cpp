@@ -0,0 +1,120 @@
+#include "fdt-cells.hpp"
+
+#include <endian-conversions.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+// interrupt-parent chains are short, a longer one is a loop between controllers
+constexpr std::size_t MAX_INTERRUPT_HOPS = 64;
+
+constexpr auto to_cells(const u32 value) noexcept -> u8 {
+    return static_cast<u8>(std::min<u32>(value, 0xff));
+}
+
+// the cell counts of a node itself, its rows are scanned once for all of them
+void scan_cells(const fdt::tree &value, const fdt::index node, fdt::cell_plan &plan) noexcept {
+    for (auto &&child : value.children(value.nodes[node])) {
+        if (fdt::entry_type::property != child.type)
+            continue;
+
+        const auto &property = value.properties[child.value];
+        if (4 != property.data.size() || property.name > fdt::id(fdt::known_name::interrupt_parent))
+            continue;
+
+        const auto cell = read_data_32be<u32>(property.data.data());
+        switch (static_cast<fdt::known_name>(property.name)) {
+            case fdt::known_name::address_cells:
+                plan.child_address = to_cells(cell);
+                break;
+            case fdt::known_name::size_cells:
+                plan.child_size = to_cells(cell);
+                break;
+            case fdt::known_name::interrupt_cells:
+                plan.own_interrupt = to_cells(cell);
+                break;
+            case fdt::known_name::interrupt_parent:
+                plan.interrupt_parent = cell;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+// only looked at for a missing interrupt provider, a lazy tree usually stops at its first nodes
+auto has_deferred(const fdt::tree &value) noexcept -> bool {
+    return std::ranges::any_of(value.nodes, [](const fdt::node_entry &node) { return fdt::npos != node.deferred; });
+}
+
+// ancestors are resolved top-down, each from the counts of its parent
+void resolve_layout(fdt::tree &value, const fdt::index node) {
+    std::vector<fdt::index> pending;
+    for (auto id = node; fdt::npos != id && !value.nodes[id].cells.resolved; id = value.nodes[id].parent)
+        pending.emplace_back(id);
+
+    for (auto iter = pending.rbegin(); iter != pending.rend(); ++iter) {
+        auto &entry = value.nodes[*iter];
+
+        // an embedded blob starts over with the defaults of a root node
+        if (fdt::npos != entry.parent && !entry.embedded) {
+            const auto &parent = value.nodes[entry.parent].cells;
+            entry.cells.address = parent.child_address;
+            entry.cells.size = parent.child_size;
+        }
+
+        scan_cells(value, *iter, entry.cells);
+        entry.cells.resolved = true;
+    }
+}
+
+// every node passed on the way shares the rest of the chain and gets the same answer
+void resolve_interrupt(fdt::tree &value, const fdt::phandle_index &phandles, const fdt::index node) {
+    std::vector<fdt::index> chain;
+    auto cells = u8{0};
+    auto final = true;
+
+    for (auto id = node; chain.size() < MAX_INTERRUPT_HOPS;) {
+        const auto &plan = value.nodes[id].cells;
+        if (plan.interrupt_resolved) {
+            cells = plan.interrupt;
+            break;
+        }
+
+        chain.emplace_back(id);
+
+        const auto next = plan.interrupt_parent ? phandles.find(plan.interrupt_parent) : value.nodes[id].parent;
+        if (fdt::npos == next) {
+            // a provider in a deferred node shows up once it is parsed, without one it never does
+            final = !plan.interrupt_parent || !has_deferred(value);
+            break;
+        }
+
+        resolve_layout(value, next);
+        if (const auto count = value.nodes[next].cells.own_interrupt) {
+            cells = count;
+            break;
+        }
+
+        id = next;
+    }
+
+    if (!final)
+        return;
+
+    for (auto &&id : chain) {
+        value.nodes[id].cells.interrupt = cells;
+        value.nodes[id].cells.interrupt_resolved = true;
+    }
+}
+} // namespace
+
+auto fdt::resolve_cells(tree &value, const phandle_index &phandles, const index node) -> const cell_plan & {
+    resolve_layout(value, node);
+
+    if (!value.nodes[node].cells.interrupt_resolved)
+        resolve_interrupt(value, phandles, node);
+
+    return value.nodes[node].cells;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <fdt/fdt-names.hpp>
+#include <fdt/fdt-phandles.hpp>
+#include <fdt/fdt-tree.hpp>
+#include <integer-types.hpp>
+
+namespace fdt {
+
+// fills node_entry::cells of the node, and of its ancestors where still missing; the
+// interrupt parent is followed through interrupt-parent or the parent node until one has
+// #interrupt-cells, a provider that is not parsed yet (lazy trees) is looked up again
+// while deferred nodes are left
+auto resolve_cells(tree &value, const phandle_index &phandles, index node) -> const cell_plan &;
+
+// cells per entry of reg, ranges, dma-ranges and interrupts, 0 for other properties
+constexpr auto entry_cells(const cell_plan &plan, const name_id name) noexcept -> u32 {
+    switch (static_cast<known_name>(name)) {
+        case known_name::reg:
+            return plan.address + plan.size;
+        case known_name::ranges:
+        case known_name::dma_ranges:
+            return plan.child_address + plan.address + plan.child_size;
+        case known_name::interrupts:
+            return plan.interrupt;
+        default:
+            return 0;
+    }
+}
+
+// plans that split every property into the same entries
+constexpr auto same_entries(const cell_plan &lhs, const cell_plan &rhs) noexcept -> bool {
+    return lhs.address == rhs.address && lhs.size == rhs.size && lhs.child_address == rhs.child_address &&
+        lhs.child_size == rhs.child_size && lhs.interrupt == rhs.interrupt && lhs.interrupt_resolved == rhs.interrupt_resolved;
+}
+
+} // namespace fdt
@@ -0,0 +1,219 @@
+#include "fdt-diff.hpp"
+
+#include <string_view>
+#include <unordered_map>
+
+namespace {
+class tree_diff {
+public:
+    tree_diff(fdt::tree &left, fdt::tree &right)
+            : m_left(left)
+            , m_right(right) {}
+
+    void run() {
+        compare(0, 0);
+
+        // one level of pending pairs at a time, expanding drops the hashes of both trees
+        while (!m_pending.empty()) {
+            const auto pending = std::move(m_pending);
+            m_pending.clear();
+
+            for (auto &&[left, right] : pending) {
+                fdt::commit_expansion(m_left, fdt::prepare_expansion(m_left, left));
+                fdt::commit_expansion(m_right, fdt::prepare_expansion(m_right, right));
+            }
+
+            for (auto value : {&m_left, &m_right})
+                if (value->hashes.size() != value->nodes.size())
+                    fdt::update_hashes(*value);
+
+            for (auto &&[left, right] : pending)
+                compare(left, right);
+        }
+    }
+
+private:
+    void compare(const fdt::index left, const fdt::index right) {
+        if (m_left.hashes[left] == m_right.hashes[right])
+            return;
+
+        // a deferred node only hashes equal to the same deferred contents, differing ones
+        // are parsed and compared row by row
+        if (fdt::npos != m_left.nodes[left].deferred || fdt::npos != m_right.nodes[right].deferred) {
+            m_pending.emplace_back(left, right);
+            return;
+        }
+
+        // rows of the right node by name, properties and nodes have separate namespaces
+        std::unordered_map<std::string_view, fdt::index> nodes;
+        std::unordered_map<std::string_view, fdt::index> properties;
+        for (auto &&child : m_right.children(m_right.nodes[right])) {
+            if (fdt::entry_type::node == child.type)
+                nodes.emplace(m_right.nodes[child.value].name, child.value);
+            else
+                properties.emplace(m_right.name(m_right.properties[child.value]), child.value);
+        }
+
+        for (auto &&child : m_left.children(m_left.nodes[left])) {
+            if (fdt::entry_type::property == child.type) {
+                const auto &property = m_left.properties[child.value];
+                const auto iter = properties.find(m_left.name(property));
+                if (properties.end() == iter) {
+                    m_result.push_back({fdt::change::removed, fdt::entry_type::property, child.value, fdt::npos});
+                    continue;
+                }
+
+                if (property.data != m_right.properties[iter->second].data)
+                    m_result.push_back({fdt::change::modified, fdt::entry_type::property, child.value, iter->second});
+
+                properties.erase(iter);
+                continue;
+            }
+
+            const auto iter = nodes.find(m_left.nodes[child.value].name);
+            if (nodes.end() == iter) {
+                m_result.push_back({fdt::change::removed, fdt::entry_type::node, child.value, fdt::npos});
+                continue;
+            }
+
+            compare(child.value, iter->second);
+            nodes.erase(iter);
+        }
+
+        // whatever was not matched only exists on the right, reported in row order
+        for (auto &&child : m_right.children(m_right.nodes[right])) {
+            const auto added = fdt::entry_type::node == child.type ? nodes.contains(m_right.nodes[child.value].name) : properties.contains(m_right.name(m_right.properties[child.value]));
+            if (added)
+                m_result.push_back({fdt::change::added, child.type, fdt::npos, child.value});
+        }
+    }
+
+public:
+    auto result() noexcept -> std::vector<fdt::difference> && {
+        return std::move(m_result);
+    }
+
+private:
+    fdt::tree &m_left;
+    fdt::tree &m_right;
+    std::vector<fdt::difference> m_result;
+    std::vector<std::pair<fdt::index, fdt::index>> m_pending;
+};
+} // namespace
+
+auto fdt::diff(tree &left, tree &right) -> std::vector<difference> {
+    if (left.nodes.empty() || right.nodes.empty())
+        return {};
+
+    for (auto value : {&left, &right})
+        if (value->hashes.size() != value->nodes.size())
+            update_hashes(*value);
+
+    tree_diff engine(left, right);
+    engine.run();
+    return engine.result();
+}
+
+namespace {
+class tree_mapper {
+public:
+    tree_mapper(fdt::tree &previous, fdt::tree &next)
+            : m_previous(previous)
+            , m_next(next) {
+        m_result.nodes.assign(previous.nodes.size(), fdt::npos);
+        m_result.properties.assign(previous.properties.size(), fdt::npos);
+        m_result.unchanged.assign(previous.nodes.size(), 0);
+    }
+
+    void run() {
+        match(0, 0);
+
+        // expanding drops the hashes of next, so it waits until they are no longer compared
+        m_hashed = false;
+        while (!m_pending.empty()) {
+            const auto [previous, next] = m_pending.back();
+            m_pending.pop_back();
+            fdt::commit_expansion(m_next, fdt::prepare_expansion(m_next, next));
+            match(previous, next);
+        }
+    }
+
+    auto result() noexcept -> fdt::tree_mapping && {
+        return std::move(m_result);
+    }
+
+private:
+    void match(const fdt::index previous, const fdt::index next) {
+        m_result.nodes[previous] = next;
+
+        const auto &node = m_previous.nodes[previous];
+        if (fdt::npos != node.deferred)
+            return;
+
+        if (fdt::npos != m_next.nodes[next].deferred) {
+            m_pending.emplace_back(previous, next);
+            return;
+        }
+
+        if (m_hashed && m_previous.hashes[previous] == m_next.hashes[next])
+            return same(previous, next);
+
+        std::unordered_map<std::string_view, fdt::index> nodes;
+        std::unordered_map<std::string_view, fdt::index> properties;
+        for (auto &&child : m_next.children(m_next.nodes[next])) {
+            if (fdt::entry_type::node == child.type)
+                nodes.emplace(m_next.nodes[child.value].name, child.value);
+            else
+                properties.emplace(m_next.name(m_next.properties[child.value]), child.value);
+        }
+
+        for (auto &&child : m_previous.children(node)) {
+            if (fdt::entry_type::property == child.type) {
+                const auto iter = properties.find(m_previous.name(m_previous.properties[child.value]));
+                if (properties.end() != iter)
+                    m_result.properties[child.value] = iter->second;
+                continue;
+            }
+
+            const auto iter = nodes.find(m_previous.nodes[child.value].name);
+            if (nodes.end() != iter)
+                match(child.value, iter->second);
+        }
+    }
+
+    // equal hashes, both subtrees have the same rows in the same order
+    void same(const fdt::index previous, const fdt::index next) {
+        m_result.nodes[previous] = next;
+        m_result.unchanged[previous] = 1;
+
+        const auto rows = m_previous.children(m_previous.nodes[previous]);
+        const auto next_rows = m_next.children(m_next.nodes[next]);
+        for (std::size_t i = 0; i < rows.size() && i < next_rows.size(); ++i) {
+            if (fdt::entry_type::property == rows[i].type)
+                m_result.properties[rows[i].value] = next_rows[i].value;
+            else
+                same(rows[i].value, next_rows[i].value);
+        }
+    }
+
+private:
+    fdt::tree &m_previous;
+    fdt::tree &m_next;
+    fdt::tree_mapping m_result;
+    std::vector<std::pair<fdt::index, fdt::index>> m_pending;
+    bool m_hashed{true};
+};
+} // namespace
+
+auto fdt::map_entries(tree &previous, tree &next) -> tree_mapping {
+    tree_mapper mapper(previous, next);
+    if (previous.nodes.empty() || next.nodes.empty())
+        return mapper.result();
+
+    for (auto value : {&previous, &next})
+        if (value->hashes.size() != value->nodes.size())
+            update_hashes(*value);
+
+    mapper.run();
+    return mapper.result();
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <fdt/fdt-tree.hpp>
+
+#include <vector>
+
+namespace fdt {
+
+enum class change : u8 {
+    added,
+    removed,
+    modified,
+};
+
+// one differing entry, index into the tree it exists in; added and removed nodes cover
+// their whole subtree
+struct difference {
+    change kind{change::modified};
+    entry_type type{entry_type::node};
+    index left{npos};
+    index right{npos};
+};
+
+// compares two trees by node and property names, subtrees with equal hashes are skipped;
+// deferred nodes are expanded where they differ from the other side, so a model over either
+// tree has to expand them itself beforehand (see tree_model::expand_all)
+auto diff(tree &left, tree &right) -> std::vector<difference>;
+
+// where the entries of a tree went in a newer version of it, npos for removed ones
+struct tree_mapping {
+    std::vector<index> nodes;
+    std::vector<index> properties;
+    std::vector<u8> unchanged; // per previous node, the whole subtree is equal
+};
+
+// matches a re-read tree against its previous version; equal subtrees are mapped row by row,
+// others by name. Nodes expanded in previous are expanded in next as well
+auto map_entries(tree &previous, tree &next) -> tree_mapping;
+
+} // namespace fdt
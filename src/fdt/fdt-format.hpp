@@ -0,0 +1,122 @@
+#pragma once
+
+#include <integer-types.hpp>
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <string_view>
+
+namespace fdt {
+
+enum class cell_format : u8 {
+    bytes, // [00 01 02]
+    u32,   // <0x00001000 0x00000100>
+    u64,   // <0x0000000000001000>
+};
+
+namespace detail {
+constexpr auto hex_pairs = [] {
+    constexpr std::string_view digits = "0123456789abcdef";
+    std::array<std::array<char, 2>, 256> ret{};
+    for (std::size_t i = 0; i < ret.size(); ++i)
+        ret[i] = {digits[i >> 4], digits[i & 0x0f]};
+    return ret;
+}();
+
+constexpr auto TRUNCATED = std::string_view(" ...");
+
+constexpr auto cell_width(const cell_format format, const std::size_t size) noexcept -> std::size_t {
+    const std::size_t width = cell_format::u64 == format ? 8 : cell_format::u32 == format ? 4 : 1;
+    return size % width ? 1 : width; // data that does not split into whole cells is shown as bytes
+}
+} // namespace detail
+
+constexpr auto NO_LIMIT = std::numeric_limits<std::size_t>::max();
+
+// upper bound of the characters format_cells writes
+constexpr auto formatted_size(const std::size_t size, const cell_format format, const std::size_t limit = NO_LIMIT) noexcept -> std::size_t {
+    const auto width = detail::cell_width(format, size);
+    const auto cells = (size < limit ? size : limit) / width;
+    const auto cell = width * 2 + (width > 1 ? 2 : 0) + 1;
+    return 2 + cells * cell + detail::TRUNCATED.size();
+}
+
+// writes data as big-endian cells into out, which has to hold formatted_size() characters;
+// at most limit bytes are shown. Returns the end of the written text
+template <typename char_type>
+constexpr auto format_cells(const std::string_view data, const cell_format format, char_type *out, const std::size_t limit = NO_LIMIT) noexcept -> char_type * {
+    const auto width = detail::cell_width(format, data.size());
+    const auto size = data.size() > limit ? limit - limit % width : data.size();
+
+    *out++ = static_cast<char_type>(width > 1 ? '<' : '[');
+
+    // cells are stored big-endian, so their digits are the byte pairs in memory order
+    for (std::size_t i = 0; i < size; i += width) {
+        if (i) *out++ = static_cast<char_type>(' ');
+
+        if (width > 1) {
+            *out++ = static_cast<char_type>('0');
+            *out++ = static_cast<char_type>('x');
+        }
+
+        for (std::size_t j = 0; j < width; ++j) {
+            const auto &pair = detail::hex_pairs[static_cast<u8>(data[i + j])];
+            *out++ = static_cast<char_type>(pair[0]);
+            *out++ = static_cast<char_type>(pair[1]);
+        }
+    }
+
+    if (size != data.size())
+        for (auto &&c : detail::TRUNCATED)
+            *out++ = static_cast<char_type>(c);
+
+    *out++ = static_cast<char_type>(width > 1 ? '>' : ']');
+    return out;
+}
+
+// upper bound of the characters format_entries writes
+constexpr auto entries_size(const std::size_t cells, const std::size_t group, const std::size_t limit = NO_LIMIT) noexcept -> std::size_t {
+    const auto shown = cells < limit || limit < group ? cells : limit;
+    const auto groups = (shown + group - 1) / group;
+    return shown * 11 + groups * 4 + detail::TRUNCATED.size();
+}
+
+// writes cells as entries of group cells in dtc notation, <0x0 0x1000>, <0x0 0x2000>;
+// at most limit cells are shown, rounded down to whole entries. Returns the end of the text
+template <typename char_type>
+constexpr auto format_entries(std::span<const u32> cells, const std::size_t group, char_type *out, const std::size_t limit = NO_LIMIT) noexcept -> char_type * {
+    const auto size = cells.size() > limit && limit >= group ? limit - limit % group : cells.size();
+
+    for (std::size_t i = 0; i < size; ++i) {
+        if (i % group == 0) {
+            if (i) {
+                *out++ = static_cast<char_type>('>');
+                *out++ = static_cast<char_type>(',');
+                *out++ = static_cast<char_type>(' ');
+            }
+            *out++ = static_cast<char_type>('<');
+        } else
+            *out++ = static_cast<char_type>(' ');
+
+        *out++ = static_cast<char_type>('0');
+        *out++ = static_cast<char_type>('x');
+
+        // without leading zeros, one digit for every started nibble
+        const auto value = cells[i];
+        const auto digits = value ? (static_cast<std::size_t>(std::bit_width(value)) + 3) / 4 : 1;
+        for (auto digit = digits; digit-- > 0;)
+            *out++ = static_cast<char_type>(detail::hex_pairs[(value >> (digit * 4)) & 0x0f][1]);
+    }
+
+    if (size != cells.size())
+        for (auto &&c : detail::TRUNCATED)
+            *out++ = static_cast<char_type>(c);
+
+    *out++ = static_cast<char_type>('>');
+    return out;
+}
+
+} // namespace fdt
@@ -1,20 +1,46 @@
 #pragma once
 
-#include <QByteArray>
-#include <QString>
+#include <fdt/fdt-names.hpp>
+#include <integer-types.hpp>
+
+#include <concepts>
+#include <string_view>
 
 struct fdt_property {
-    QString name;
-    QByteArray data;
+    fdt::name_id id{fdt::invalid_name_id};
+    std::string_view name{}; // interned, owned by the parser's name_table
+    std::string_view data; // view into the loaded blob, see tree_info::blobs
 
     auto clear() noexcept {
-        name.clear();
-        data.clear();
+        id = fdt::invalid_name_id;
+        name = {};
+        data = {};
     }
 };
 
+// contents of a node within the structure block of a blob, offsets are relative to the fdt header
+struct fdt_span {
+    const char *fdt{nullptr};
+    u32 begin{0}; // first token after the node name
+    u32 end{0};   // the matching end_node token
+    bool root{false}; // contents of the root node of a blob, see fdt_parser::root_span
+};
+
 struct iface_fdt_generator {
-    virtual void begin_node(const QString &name) noexcept = 0;
+    virtual void begin_node(std::string_view name) noexcept = 0;
     virtual void end_node() noexcept = 0;
     virtual void insert_property(const fdt_property &property) noexcept = 0;
+    virtual void deferred_node(std::string_view name, const fdt_span &span) noexcept = 0;
 };
+
+// what the parser emits into; the templated front-end takes any such sink directly, see
+// basic_fdt_parser, iface_fdt_generator is the virtual one
+template <typename type>
+concept fdt_generator = requires(type &value, std::string_view name, const fdt_property &property, const fdt_span &span) {
+    value.begin_node(name);
+    value.end_node();
+    value.insert_property(property);
+    value.deferred_node(name, span);
+};
+
+static_assert(fdt_generator<iface_fdt_generator>);
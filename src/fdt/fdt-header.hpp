@@ -1,6 +1,6 @@
 #pragma once
 
-#include <types.hpp>
+#include <integer-types.hpp>
 
 constexpr auto FDT_MAGIC_VALUE = 0xD00DFEED;
 constexpr auto FDT_SUPPORT_ABOVE = 16;
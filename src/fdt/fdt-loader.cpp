@@ -0,0 +1,94 @@
+#include "fdt-loader.hpp"
+
+#include <fdt/fdt-cache.hpp>
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+namespace {
+// smaller files are cheaper to read than to keep a mapping (and its descriptor) around
+constexpr auto MAP_THRESHOLD = 1024 * 1024;
+
+// one index per file, named after its absolute path
+auto index_path(const string &cache, const file_info &info) -> string {
+    const auto name = QCryptographicHash::hash(info.absoluteFilePath().toUtf8(), QCryptographicHash::Sha1).toHex();
+    return QDir(cache).filePath(string::fromLatin1(name) + ".fdtindex");
+}
+
+// the mapping is only needed while the tables are copied out of it
+auto read_index(const string &path, const fdt::blob &source, const fdt::cache_key &key) -> std::optional<fdt::tree> {
+    file index(path);
+    if (!index.open(QIODevice::ReadOnly) || 0 == index.size())
+        return {};
+
+    const auto map = index.map(0, index.size());
+    if (!map)
+        return {};
+
+    return fdt::load_index({reinterpret_cast<const char *>(map), static_cast<std::size_t>(index.size())}, source, key);
+}
+
+// a failed write only costs the next open a parse
+void write_index(const string &path, const fdt::tree &value, const fdt::cache_key &key) {
+    const auto data = fdt::save_index(value, key);
+    if (!data || !QDir().mkpath(file_info(path).absolutePath()))
+        return;
+
+    QSaveFile index(path);
+    if (index.open(QIODevice::WriteOnly) && index.write(data->data(), static_cast<qint64>(data->size())) == static_cast<qint64>(data->size()))
+        index.commit();
+}
+} // namespace
+
+auto fdt::load_file(const string &path, const file_access access) -> std::optional<blob> {
+    auto source = std::make_shared<file>(path);
+    if (!source->open(QIODevice::ReadOnly))
+        return {};
+
+    const auto size = source->size();
+
+    if (file_access::map == access && !source->isSequential() && size >= MAP_THRESHOLD) {
+        const auto map = source->map(0, size);
+        if (map)
+            return blob{{reinterpret_cast<const char *>(map), static_cast<std::size_t>(size)}, source};
+    }
+
+    // pipes and special files (/proc, /sys) cannot be mapped or report no size
+    auto buffer = std::make_shared<byte_array>(source->readAll());
+    return blob{{buffer->constData(), static_cast<std::size_t>(buffer->size())}, buffer};
+}
+
+auto fdt::load_tree(const string &path, const parse_mode mode, const string &cache, const file_access access) -> loaded_file {
+    loaded_file ret{path, nullptr};
+
+    const auto source = load_file(path, access);
+    if (!source)
+        return ret;
+
+    // special files report a size that does not match what was read, they are never cached
+    const file_info info(path);
+    const cache_key key{static_cast<u64>(info.size()), info.lastModified().toMSecsSinceEpoch(), mode};
+    const auto cached = !cache.isEmpty() && key.size == source->data.size() ? index_path(cache, info) : string{};
+
+    if (!cached.isEmpty()) {
+        if (auto value = read_index(cached, source.value(), key)) {
+            ret.tree = std::make_shared<tree>(std::move(value.value()));
+            return ret;
+        }
+    }
+
+    auto value = parse_tree(source.value(), mode);
+    if (!value)
+        return ret;
+
+    if (!cached.isEmpty())
+        write_index(cached, value.value(), key);
+
+    ret.tree = std::make_shared<tree>(std::move(value.value()));
+    return ret;
+}
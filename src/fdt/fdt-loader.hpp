@@ -0,0 +1,32 @@
+#pragma once
+
+#include <fdt/fdt-blob.hpp>
+#include <fdt/fdt-tree.hpp>
+#include <types.hpp>
+
+#include <QString>
+
+#include <memory>
+#include <optional>
+
+namespace fdt {
+
+struct loaded_file {
+    string path;
+    std::shared_ptr<fdt::tree> tree; // empty when the file could not be read or parsed
+};
+
+enum class file_access {
+    copy, // read into memory, for files that are watched and may change while they are shown
+    map,  // large files are mapped, only for files read once; a file shrinking underneath
+          // its mapping faults on the next access
+};
+
+auto load_file(const string &path, file_access access = file_access::copy) -> std::optional<blob>;
+
+// reads and parses a whole file, safe to run on worker threads; with a cache directory an
+// unchanged file is restored from its index there and a parsed one gets a new index
+auto load_tree(const string &path, parse_mode mode = parse_mode::full, const string &cache = {},
+    file_access access = file_access::copy) -> loaded_file;
+
+} // namespace fdt
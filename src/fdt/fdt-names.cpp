@@ -0,0 +1,24 @@
+#include "fdt-names.hpp"
+
+fdt::name_table::name_table() {
+    for (auto &&name : known_names)
+        intern(name);
+}
+
+auto fdt::name_table::intern(std::string_view name) -> name_id {
+    if (const auto iter = m_ids.find(name); iter != m_ids.end())
+        return iter->second;
+
+    const auto id = static_cast<name_id>(m_names.size());
+    m_names.emplace_back(name);
+    m_types.emplace_back(classify(name));
+    m_ids.emplace(m_names.back(), id);
+    return id;
+}
+
+auto fdt::name_table::find(std::string_view name) const noexcept -> std::optional<name_id> {
+    if (const auto iter = m_ids.find(name); iter != m_ids.end())
+        return iter->second;
+
+    return {};
+}
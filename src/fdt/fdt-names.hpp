@@ -0,0 +1,84 @@
+#pragma once
+
+#include <fdt/fdt-property-types.hpp>
+#include <integer-types.hpp>
+
+#include <array>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace fdt {
+
+using name_id = u32;
+
+constexpr auto invalid_name_id = static_cast<name_id>(-1);
+
+// names every table interns up front, so their ids are the same for all blobs; the
+// #*-cells names and interrupt-parent stay next to each other, see fdt-cells.cpp
+enum class known_name : name_id {
+    data,
+    compatible,
+    phandle,
+    pinctrl_names,
+    data_size,
+    data_offset,
+    data_position,
+    address_cells,
+    size_cells,
+    interrupt_cells,
+    interrupt_parent,
+    reg,
+    ranges,
+    dma_ranges,
+    interrupts,
+};
+
+constexpr std::array<std::string_view, 15> known_names{
+    "data",
+    "compatible",
+    "phandle",
+    "pinctrl-names",
+    "data-size",
+    "data-offset",
+    "data-position",
+    "#address-cells",
+    "#size-cells",
+    "#interrupt-cells",
+    "interrupt-parent",
+    "reg",
+    "ranges",
+    "dma-ranges",
+    "interrupts",
+};
+
+constexpr auto id(const known_name value) noexcept -> name_id {
+    return static_cast<name_id>(value);
+}
+
+class name_table {
+public:
+    name_table();
+
+    auto intern(std::string_view name) -> name_id;
+    auto find(std::string_view name) const noexcept -> std::optional<name_id>;
+    auto name(name_id id) const noexcept -> std::string_view { return m_names[id]; }
+    auto type(name_id id) const noexcept -> property_type { return m_types[id]; }
+    auto size() const noexcept -> std::size_t { return m_names.size(); }
+
+private:
+    struct hash {
+        using is_transparent = void;
+        auto operator()(std::string_view value) const noexcept -> std::size_t { return std::hash<std::string_view>{}(value); }
+    };
+
+    std::deque<std::string> m_names; // deque keeps handed out views stable
+    std::vector<property_type> m_types; // classified once per name
+    std::unordered_map<std::string, name_id, hash, std::equal_to<>> m_ids;
+};
+
+} // namespace fdt
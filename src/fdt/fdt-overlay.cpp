@@ -0,0 +1,368 @@
+#include "fdt-overlay.hpp"
+
+#include <endian-conversions.hpp>
+#include <fdt/fdt-parser.hpp>
+
+#include <charconv>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+
+namespace {
+constexpr std::string_view FIXUPS = "__fixups__";
+constexpr std::string_view LOCAL_FIXUPS = "__local_fixups__";
+constexpr std::string_view OVERLAY = "__overlay__";
+constexpr std::string_view SYMBOLS = "__symbols__";
+
+auto read_cell(std::string_view data, const std::size_t offset) noexcept -> u32 {
+    return read_data_32be<u32>(data.data() + offset);
+}
+
+// up to the first NUL, string properties include the terminator
+auto to_string_view(std::string_view data) noexcept -> std::string_view {
+    return data.substr(0, data.find('\0'));
+}
+
+class overlay_engine {
+public:
+    overlay_engine(fdt::tree &target)
+            : m_tree(target)
+            , m_builder(target) {
+    }
+
+    auto load_base(const fdt::blob &base) -> bool;
+    auto apply(const fdt::blob &overlay) -> bool;
+    void finalize() { m_builder.finalize(); }
+
+    auto error() const noexcept -> const std::string & { return m_error; }
+
+private:
+    auto fail(std::string &&message) -> bool;
+    auto writable(const fdt::property_entry &property) noexcept -> char *;
+    void write_cell(const fdt::property_entry &property, std::size_t offset, u32 value) noexcept;
+
+    void index_properties(fdt::index first);
+    auto phandle_of(fdt::index node) const noexcept -> std::optional<u32>;
+    auto own(std::string &&value) -> std::string_view;
+
+    auto local_fixups(fdt::index fixups, fdt::index node, u32 delta) -> bool;
+    auto fixups(fdt::index fixups) -> bool;
+    auto merge(fdt::index fragment, std::unordered_map<std::string_view, std::string> &targets) -> bool;
+    auto symbols(fdt::index symbols, const std::unordered_map<std::string_view, std::string> &targets) -> bool;
+    void replay(fdt::index node);
+
+private:
+    fdt::tree &m_tree;
+    fdt::tree_builder m_builder;
+    std::unordered_map<u32, fdt::index> m_phandles;        // phandle -> node of the merged tree
+    std::unordered_map<std::string, std::string> m_labels; // label -> path, from __symbols__
+    u32 m_max_phandle{0};
+    std::string m_error;
+
+    // overlay being applied, parsed from a private copy that fixups patch in place
+    std::optional<fdt::tree> m_overlay;
+    std::shared_ptr<std::string> m_overlay_data;
+};
+
+auto overlay_engine::load_base(const fdt::blob &base) -> bool {
+    m_tree.blobs.emplace_back(base);
+
+    basic_fdt_parser parser(base.data.data(), base.data.size(), m_builder, m_tree.names);
+    if (!parser.is_valid())
+        return fail("base is not a valid devicetree blob");
+
+    index_properties(0);
+    return true;
+}
+
+auto overlay_engine::apply(const fdt::blob &overlay) -> bool {
+    m_overlay_data = std::make_shared<std::string>(overlay.data);
+    m_overlay = fdt::parse_tree({*m_overlay_data, m_overlay_data});
+    if (!m_overlay)
+        return fail("overlay is not a valid devicetree blob");
+
+    const auto &value = m_overlay.value();
+    const auto first_property = static_cast<fdt::index>(m_tree.properties.size());
+
+    // phandles of the overlay are moved above every phandle in use, references to them
+    // are listed in __local_fixups__
+    const auto delta = m_max_phandle;
+    const auto phandle = value.names.find("phandle");
+    const auto linux_phandle = value.names.find("linux,phandle");
+    for (auto &&property : value.properties)
+        if ((property.name == phandle || property.name == linux_phandle) && 4 == property.data.size())
+            write_cell(property, 0, read_cell(property.data, 0) + delta);
+
+    if (const auto node = fdt::find_child(value, 0, LOCAL_FIXUPS); fdt::npos != node)
+        if (!local_fixups(node, 0, delta))
+            return false;
+
+    if (const auto node = fdt::find_child(value, 0, FIXUPS); fdt::npos != node)
+        if (!fixups(node))
+            return false;
+
+    std::unordered_map<std::string_view, std::string> targets; // fragment name -> target path
+    for (auto &&child : value.children(value.nodes[0])) {
+        if (fdt::entry_type::node != child.type)
+            continue;
+
+        const auto name = value.nodes[child.value].name;
+        if (name == FIXUPS || name == LOCAL_FIXUPS || name == SYMBOLS)
+            continue;
+
+        if (!merge(child.value, targets))
+            return false;
+    }
+
+    if (const auto node = fdt::find_child(value, 0, SYMBOLS); fdt::npos != node)
+        if (!symbols(node, targets))
+            return false;
+
+    index_properties(first_property);
+
+    // merged nodes and values are views into the patched copy
+    m_tree.blobs.push_back({*m_overlay_data, m_overlay_data});
+    m_overlay.reset();
+    return true;
+}
+
+auto overlay_engine::fail(std::string &&message) -> bool {
+    m_error = std::move(message);
+    return false;
+}
+
+auto overlay_engine::writable(const fdt::property_entry &property) noexcept -> char * {
+    return m_overlay_data->data() + (property.data.data() - m_overlay_data->data());
+}
+
+void overlay_engine::write_cell(const fdt::property_entry &property, const std::size_t offset, const u32 value) noexcept {
+    const auto cell = convert(value);
+    std::memcpy(writable(property) + offset, &cell, sizeof(cell));
+}
+
+void overlay_engine::index_properties(const fdt::index first) {
+    const auto phandle = m_tree.names.find("phandle");
+    const auto linux_phandle = m_tree.names.find("linux,phandle");
+    const auto symbols = m_builder.find_path("/__symbols__");
+
+    for (auto i = first; i < m_tree.properties.size(); ++i) {
+        const auto &property = m_tree.properties[i];
+
+        if ((property.name == phandle || property.name == linux_phandle) && 4 == property.data.size()) {
+            const auto value = read_cell(property.data, 0);
+            m_phandles[value] = property.node;
+            m_max_phandle = std::max(m_max_phandle, value);
+        }
+
+        if (fdt::npos != symbols && property.node == symbols)
+            m_labels.insert_or_assign(std::string(m_tree.name(property)), std::string(to_string_view(property.data)));
+    }
+}
+
+auto overlay_engine::phandle_of(const fdt::index node) const noexcept -> std::optional<u32> {
+    for (auto &&name : {"phandle", "linux,phandle"}) {
+        const auto id = m_tree.names.find(name);
+        if (!id)
+            continue;
+
+        const auto property = m_builder.find_property(node, id.value());
+        if (fdt::npos != property && 4 == m_tree.properties[property].data.size())
+            return read_cell(m_tree.properties[property].data, 0);
+    }
+
+    return {};
+}
+
+auto overlay_engine::own(std::string &&value) -> std::string_view {
+    auto storage = std::make_shared<std::string>(std::move(value));
+    const std::string_view ret = *storage;
+    m_tree.blobs.push_back({ret, std::move(storage)});
+    return ret;
+}
+
+// __local_fixups__ mirrors the overlay, each property lists offsets of phandle cells
+// within the property of the same name
+auto overlay_engine::local_fixups(const fdt::index fixups, const fdt::index node, const u32 delta) -> bool {
+    const auto &value = m_overlay.value();
+
+    for (auto &&child : value.children(value.nodes[fixups])) {
+        if (fdt::entry_type::node == child.type) {
+            const auto name = value.nodes[child.value].name;
+            const auto target = fdt::find_child(value, node, name);
+            if (fdt::npos == target)
+                return fail("__local_fixups__ refers to missing node " + std::string(name));
+
+            if (!local_fixups(child.value, target, delta))
+                return false;
+            continue;
+        }
+
+        const auto &offsets = value.properties[child.value];
+        const auto property = fdt::find_property(value, node, value.name(offsets));
+        if (nullptr == property)
+            return fail("__local_fixups__ refers to missing property " + std::string(value.name(offsets)));
+
+        for (std::size_t i = 0; i + 4 <= offsets.data.size(); i += 4) {
+            const auto offset = read_cell(offsets.data, i);
+            if (offset + 4 > property->data.size())
+                return fail("__local_fixups__ offset outside of " + std::string(value.name(offsets)));
+
+            write_cell(*property, offset, read_cell(property->data, offset) + delta);
+        }
+    }
+
+    return true;
+}
+
+// every __fixups__ property is a label of the base, its value lists "path:property:offset"
+auto overlay_engine::fixups(const fdt::index fixups) -> bool {
+    const auto &value = m_overlay.value();
+
+    for (auto &&child : value.children(value.nodes[fixups])) {
+        if (fdt::entry_type::property != child.type)
+            continue;
+
+        const auto &fixup = value.properties[child.value];
+        const auto label = std::string(value.name(fixup));
+
+        const auto path = m_labels.find(label);
+        if (m_labels.end() == path)
+            return fail("label " + label + " is not in __symbols__ of the base");
+
+        const auto node = m_builder.find_path(path->second);
+        const auto phandle = fdt::npos == node ? std::nullopt : phandle_of(node);
+        if (!phandle)
+            return fail("label " + label + " does not point to a node with a phandle");
+
+        for (auto entries = fixup.data; !entries.empty();) {
+            const auto entry = to_string_view(entries);
+            entries.remove_prefix(std::min(entries.size(), entry.size() + 1));
+
+            const auto first = entry.find(':');
+            const auto last = entry.rfind(':');
+            if (std::string_view::npos == first || first == last)
+                return fail("malformed __fixups__ entry for " + label);
+
+            u32 offset{};
+            const auto digits = entry.substr(last + 1);
+            if (std::from_chars(digits.data(), digits.data() + digits.size(), offset).ec != std::errc{})
+                return fail("malformed __fixups__ offset for " + label);
+
+            const auto target = fdt::find_path(value, entry.substr(0, first));
+            const auto property = fdt::npos == target ? nullptr : fdt::find_property(value, target, entry.substr(first + 1, last - first - 1));
+            if (nullptr == property || offset + 4 > property->data.size())
+                return fail("__fixups__ entry " + std::string(entry) + " does not match the overlay");
+
+            write_cell(*property, offset, phandle.value());
+        }
+    }
+
+    return true;
+}
+
+auto overlay_engine::merge(const fdt::index fragment, std::unordered_map<std::string_view, std::string> &targets) -> bool {
+    const auto &value = m_overlay.value();
+
+    const auto overlay = fdt::find_child(value, fragment, OVERLAY);
+    if (fdt::npos == overlay)
+        return true;
+
+    auto target = fdt::npos;
+    if (const auto property = fdt::find_property(value, fragment, "target"); property && 4 == property->data.size()) {
+        const auto iter = m_phandles.find(read_cell(property->data, 0));
+        target = m_phandles.end() == iter ? fdt::npos : iter->second;
+    } else if (const auto property = fdt::find_property(value, fragment, "target-path"))
+        target = m_builder.find_path(to_string_view(property->data));
+
+    const auto name = value.nodes[fragment].name;
+    if (fdt::npos == target)
+        return fail("target of " + std::string(name) + " is not in the base");
+
+    targets.emplace(name, m_builder.path(target));
+
+    m_builder.enter(target);
+    replay(overlay);
+    return true;
+}
+
+// labels defined by the overlay point into its fragments, they are rewritten to the merged path
+auto overlay_engine::symbols(const fdt::index symbols, const std::unordered_map<std::string_view, std::string> &targets) -> bool {
+    const auto &value = m_overlay.value();
+
+    m_builder.enter(0);
+    m_builder.begin_node(SYMBOLS);
+
+    for (auto &&child : value.children(value.nodes[symbols])) {
+        if (fdt::entry_type::property != child.type)
+            continue;
+
+        const auto &symbol = value.properties[child.value];
+        auto path = std::string(to_string_view(symbol.data));
+
+        // "/fragment@0/__overlay__/node" becomes "<target>/node"
+        const auto fragment_end = path.find('/', 1);
+        const auto fragment = std::string_view(path).substr(1, fragment_end - 1);
+        if (const auto iter = targets.find(fragment); iter != targets.end()) {
+            const auto prefix = std::string("/").append(fragment).append("/").append(OVERLAY);
+            if (path.starts_with(prefix)) {
+                auto rest = path.substr(prefix.size());
+                path = iter->second == "/" && !rest.empty() ? rest : iter->second + rest;
+            }
+        }
+
+        fdt_property property;
+        property.id = m_tree.names.intern(value.name(symbol));
+        property.name = m_tree.names.name(property.id);
+        property.data = own(path + '\0');
+        m_builder.set_property(property);
+
+        m_labels.insert_or_assign(std::string(property.name), std::move(path));
+    }
+
+    m_builder.end_node();
+    return true;
+}
+
+void overlay_engine::replay(const fdt::index node) {
+    const auto &value = m_overlay.value();
+
+    for (auto &&child : value.children(value.nodes[node])) {
+        if (fdt::entry_type::node == child.type) {
+            m_builder.begin_node(value.nodes[child.value].name);
+            replay(child.value);
+            m_builder.end_node();
+            continue;
+        }
+
+        const auto &source = value.properties[child.value];
+
+        fdt_property property;
+        property.id = m_tree.names.intern(value.name(source));
+        property.name = m_tree.names.name(property.id);
+        property.data = source.data;
+        m_builder.set_property(property);
+    }
+}
+} // namespace
+
+auto fdt::apply_overlays(const blob &base, std::span<const blob> overlays) -> overlay_result {
+    overlay_result ret;
+    tree value;
+
+    overlay_engine engine(value);
+    if (!engine.load_base(base)) {
+        ret.error = engine.error();
+        return ret;
+    }
+
+    for (std::size_t i = 0; i < overlays.size(); ++i) {
+        if (!engine.apply(overlays[i])) {
+            ret.error = "overlay " + std::to_string(i + 1) + ": " + engine.error();
+            return ret;
+        }
+    }
+
+    engine.finalize();
+    ret.value = std::move(value);
+    return ret;
+}
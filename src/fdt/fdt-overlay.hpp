@@ -0,0 +1,23 @@
+#pragma once
+
+#include <fdt/fdt-blob.hpp>
+#include <fdt/fdt-tree.hpp>
+
+#include <optional>
+#include <span>
+#include <string>
+
+namespace fdt {
+
+struct overlay_result {
+    std::optional<tree> value;
+    std::string error; // why applying stopped, empty on success
+};
+
+// applies overlays in order on top of base the way libfdt's fdt_overlay_apply does:
+// overlay phandles are renumbered above the ones in use (__local_fixups__), references to
+// labels are resolved through __symbols__ (__fixups__) and every fragment's __overlay__ is
+// merged into its target. The inputs are not modified, patched values live in the result
+auto apply_overlays(const blob &base, std::span<const blob> overlays) -> overlay_result;
+
+} // namespace fdt
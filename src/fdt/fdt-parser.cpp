@@ -1,77 +1,66 @@
 #include "fdt-parser.hpp"
 
-#include <cstring>
-#include <endian-conversions.hpp>
-
-fdt_parser::fdt_parser(const char *data, u64 size, iface_fdt_generator &generator, const QString &default_root_node, const std::vector<fdt_handle_special_property> &handle_special_properties)
-        : m_data(data)
-        , m_size(size)
-        , m_default_root_node(default_root_node)
-        , m_handle_special_properties(handle_special_properties) {
-    if (size >= sizeof(fdt::header)) {
-        auto header = read_data_32be<fdt::header>(data);
-        if (FDT_MAGIC_VALUE != header.magic)
-            return;
-
-        if (size < header.totalsize)
-            return;
-
-        if (FDT_SUPPORT_ABOVE > header.version)
-            return;
-
-        m_header = std::move(header);
-        parse(m_header.value(), generator);
-    }
+template class basic_fdt_parser<iface_fdt_generator, fdt_property_callback>;
+
+auto fdt_parser::root_span(const char *data, u64 size) -> std::optional<fdt_span> {
+    const auto header = fdt::validate(data, size);
+    if (!header)
+        return {};
+
+    auto iter = data + header->off_dt_struct;
+    const auto end = iter + header->size_dt_struct;
+
+    while (iter < end && fdt::token::nop == fdt::read_token(iter))
+        iter += sizeof(fdt::token);
+
+    if (iter >= end || fdt::token::begin_node != fdt::read_token(iter))
+        return {};
+
+    iter += sizeof(fdt::token);
+    iter = fdt::seek_and_align(iter, std::strlen(iter) + 1);
+
+    const auto node_end = fdt::find_end_node(iter, end);
+    return fdt_span{data, static_cast<u32>(iter - data), static_cast<u32>(node_end - data), true};
 }
 
-void fdt_parser::parse(const fdt::header header, iface_fdt_generator &generator) {
-    const auto dt_struct = m_data + header.off_dt_struct;
-    const auto dt_strings = m_data + header.off_dt_strings;
+auto fdt::validate(const char *data, u64 size) -> std::optional<header> {
+    if (size < sizeof(fdt::header))
+        return {};
 
-    auto get_property_name = [&](auto offset) {
-        const auto ptr = dt_strings + offset;
-        return QString::fromUtf8(ptr, std::strlen(ptr));
-    };
+    auto header = read_data_32be<fdt::header>(data);
+    if (FDT_MAGIC_VALUE != header.magic)
+        return {};
 
-    for (auto iter = dt_struct; iter < dt_struct + header.size_dt_struct;) {
-        auto seek_and_align = [&iter](const std::size_t size) {
-            const auto value = size % sizeof(fdt::token);
-            if (value)
-                return iter += size + sizeof(fdt::token) - value;
+    if (size < header.totalsize)
+        return {};
 
-            return iter += size;
-        };
+    if (FDT_SUPPORT_ABOVE > header.version)
+        return {};
 
-        const auto token = static_cast<fdt::token>(convert(*reinterpret_cast<const u32 *>(iter)));
-        seek_and_align(sizeof(token));
+    return header;
+}
+
+auto fdt::find_end_node(const char *iter, const char *end) noexcept -> const char * {
+    for (auto depth = 0; iter < end;) {
+        const auto token = read_token(iter);
+        if (fdt::token::end_node == token && 0 == depth--)
+            return iter;
+
+        iter += sizeof(token);
 
         if (fdt::token::begin_node == token) {
-            const auto size = std::strlen(iter);
-            auto name = QString::fromUtf8(iter, size);
-            seek_and_align(size);
-            generator.begin_node(size ? name : m_default_root_node);
+            iter = seek_and_align(iter, std::strlen(iter) + 1);
+            ++depth;
         }
 
-        if (fdt::token::end_node == token)
-            generator.end_node();
-
         if (fdt::token::property == token) {
             const auto header = read_data_32be<fdt::property>(iter);
-            seek_and_align(sizeof(header));
-
-            fdt_property property;
-            property.data = QByteArray(iter, header.len);
-            seek_and_align(header.len);
-
-            property.name = get_property_name(header.nameoff);
-            generator.insert_property(property);
-
-            for (auto &&handle : m_handle_special_properties)
-                if (handle.name == property.name)
-                    handle.callback(property, generator);
+            iter = seek_and_align(iter + sizeof(header), header.len);
         }
 
         if (fdt::token::end == token)
             break;
     }
+
+    return end;
 }
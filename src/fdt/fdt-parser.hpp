@@ -2,36 +2,181 @@
 
 #include <fdt/fdt-header.hpp>
 
+#include <cstring>
 #include <functional>
+#include <initializer_list>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
+#include <endian-conversions.hpp>
 #include <fdt/fdt-generator.hpp>
 
-using fdt_property_callback = std::function<void(const fdt_property &property, iface_fdt_generator &generator)>;
+namespace fdt {
+
+inline auto read_token(const char *iter) noexcept -> token {
+    return static_cast<token>(read_data_32be<u32>(iter));
+}
+
+// every item of the structure block starts on a token boundary
+inline auto seek_and_align(const char *iter, const std::size_t size) noexcept -> const char * {
+    const auto value = size % sizeof(token);
+    return iter + size + (value ? sizeof(token) - value : 0);
+}
+
+// header of a blob that is supported and fits into size
+auto validate(const char *data, u64 size) -> std::optional<header>;
+// the end_node token closing the node whose contents start at iter, end if there is none
+auto find_end_node(const char *iter, const char *end) noexcept -> const char *;
+
+} // namespace fdt
 
-struct fdt_handle_special_property {
-    QString name;
-    fdt_property_callback callback;
+// handlers of special properties by name id, a property costs one lookup however many
+// handlers there are; callback is invoked as callback(property, generator)
+template <typename callback>
+class fdt_special_properties {
+public:
+    fdt_special_properties() = default;
+    fdt_special_properties(std::initializer_list<std::pair<fdt::name_id, callback>> values) {
+        for (auto &&[id, value] : values) {
+            if (id >= m_slots.size())
+                m_slots.resize(id + 1, 0);
+
+            m_callbacks.emplace_back(value);
+            m_slots[id] = static_cast<u32>(m_callbacks.size());
+        }
+    }
+
+    auto find(const fdt::name_id id) const noexcept -> const callback * {
+        return id < m_slots.size() && m_slots[id] ? &m_callbacks[m_slots[id] - 1] : nullptr;
+    }
+
+private:
+    std::vector<u32> m_slots; // per name id, 0 for none or the position of the callback + 1
+    std::vector<callback> m_callbacks;
 };
 
-class fdt_parser {
+struct fdt_no_special_property {
+    void operator()(const fdt_property &, auto &) const noexcept {}
+};
+
+// parser front-end instantiated per generator, the token loop calls the sink directly so its
+// methods inline into the loop
+template <fdt_generator generator, typename callback = fdt_no_special_property>
+class basic_fdt_parser {
 public:
-    fdt_parser(const char *data, u64 size, iface_fdt_generator &generator,
-        const QString &default_root_node = {},
-        const std::vector<fdt_handle_special_property> &handle_special_properties = {});
+    basic_fdt_parser(const char *data, u64 size, generator &target, fdt::name_table &names,
+        std::string_view default_root_node = {},
+        const fdt_special_properties<callback> &special_properties = {})
+            : m_header(fdt::validate(data, size)) {
+        if (!m_header)
+            return;
+
+        const auto dt_struct = data + m_header->off_dt_struct;
+        parse(data, dt_struct, dt_struct + m_header->size_dt_struct, target, names, default_root_node, special_properties, false);
+    }
+
+    // parses the contents of a single node, child nodes are reported through deferred_node
+    basic_fdt_parser(const fdt_span &span, generator &target, fdt::name_table &names,
+        const fdt_special_properties<callback> &special_properties = {}) {
+        // spans are only handed out for blobs that already passed validation
+        if (nullptr == span.fdt)
+            return;
+
+        m_header = read_data_32be<fdt::header>(span.fdt);
+        parse(span.fdt, span.fdt + span.begin, span.fdt + span.end, target, names, {}, special_properties, true);
+    }
+
     constexpr bool is_valid() noexcept { return m_header.has_value(); }
 
 private:
-    void parse(const fdt::header header, iface_fdt_generator &generator);
+    void parse(const char *data, const char *begin, const char *end, generator &target, fdt::name_table &names,
+        std::string_view default_root_node, const fdt_special_properties<callback> &special_properties, bool defer);
 
 private:
     std::optional<fdt::header> m_header;
-    const QString m_default_root_node;
-    const std::vector<fdt_handle_special_property> &m_handle_special_properties;
+};
+
+template <fdt_generator generator, typename callback>
+void basic_fdt_parser<generator, callback>::parse(const char *data, const char *begin, const char *end, generator &target, fdt::name_table &names,
+    std::string_view default_root_node, const fdt_special_properties<callback> &special_properties, const bool defer) {
+    const auto dt_strings = data + m_header->off_dt_strings;
+
+    // every distinct nameoff is decoded and interned once per blob
+    std::vector<fdt::name_id> name_ids(m_header->size_dt_strings, fdt::invalid_name_id);
+
+    auto get_property_name = [&](const u32 offset) {
+        auto intern = [&]() {
+            const auto ptr = dt_strings + offset;
+            return names.intern(std::string_view(ptr, std::strlen(ptr)));
+        };
+
+        if (offset >= name_ids.size())
+            return intern();
+
+        auto &id = name_ids[offset];
+        if (fdt::invalid_name_id == id)
+            id = intern();
+
+        return id;
+    };
+
+    for (auto iter = begin; iter < end;) {
+        const auto token = fdt::read_token(iter);
+        iter += sizeof(token);
+
+        if (fdt::token::begin_node == token) {
+            const auto size = std::strlen(iter);
+            const auto name = std::string_view(iter, size);
+            iter = fdt::seek_and_align(iter, size + 1);
+
+            if (defer) {
+                // only the extent of the child is scanned, its contents are parsed once requested
+                const auto node_end = fdt::find_end_node(iter, end);
+                target.deferred_node(name, {data, static_cast<u32>(iter - data), static_cast<u32>(node_end - data)});
+                iter = node_end + sizeof(token);
+                continue;
+            }
+
+            target.begin_node(size ? name : default_root_node);
+        }
+
+        if (fdt::token::end_node == token)
+            target.end_node();
+
+        if (fdt::token::property == token) {
+            const auto header = read_data_32be<fdt::property>(iter);
+            iter += sizeof(header);
+
+            fdt_property property;
+            property.data = std::string_view(iter, header.len);
+            iter = fdt::seek_and_align(iter, header.len);
+
+            property.id = get_property_name(header.nameoff);
+            property.name = names.name(property.id);
+            target.insert_property(property);
+
+            if (const auto handle = special_properties.find(property.id))
+                (*handle)(property, target);
+        }
+
+        if (fdt::token::end == token)
+            break;
+    }
+}
+
+using fdt_property_callback = std::function<void(const fdt_property &property, iface_fdt_generator &generator)>;
+
+extern template class basic_fdt_parser<iface_fdt_generator, fdt_property_callback>;
+
+// the virtual interface on top of the templated front-end, one instantiation for every
+// iface_fdt_generator
+class fdt_parser : public basic_fdt_parser<iface_fdt_generator, fdt_property_callback> {
+public:
+    using basic_fdt_parser::basic_fdt_parser;
 
-    const char *const m_data;
-    const u64 m_size;
+    // locates the contents of the root node without parsing them
+    static auto root_span(const char *data, u64 size) -> std::optional<fdt_span>;
 };
@@ -0,0 +1,184 @@
+#include "fdt-phandles.hpp"
+
+#include <endian-conversions.hpp>
+
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <string_view>
+
+namespace {
+struct reference_rule {
+    std::string_view name;
+    std::string_view cells; // #*-cells of the provider, empty when every cell is a phandle
+};
+
+constexpr std::array reference_rules{
+    reference_rule{"assigned-clock-parents", "#clock-cells"},
+    reference_rule{"assigned-clocks", "#clock-cells"},
+    reference_rule{"clocks", "#clock-cells"},
+    reference_rule{"cooling-device", "#cooling-cells"},
+    reference_rule{"cpu", ""},
+    reference_rule{"dmas", "#dma-cells"},
+    reference_rule{"gpios", "#gpio-cells"},
+    reference_rule{"hwlocks", "#hwlock-cells"},
+    reference_rule{"interconnects", "#interconnect-cells"},
+    reference_rule{"interrupt-parent", ""},
+    reference_rule{"interrupts-extended", "#interrupt-cells"},
+    reference_rule{"io-channels", "#io-channel-cells"},
+    reference_rule{"iommus", "#iommu-cells"},
+    reference_rule{"mboxes", "#mbox-cells"},
+    reference_rule{"memory-region", ""},
+    reference_rule{"msi-parent", "#msi-cells"},
+    reference_rule{"next-level-cache", ""},
+    reference_rule{"nvmem-cells", ""},
+    reference_rule{"operating-points-v2", ""},
+    reference_rule{"phy-handle", ""},
+    reference_rule{"phys", "#phy-cells"},
+    reference_rule{"power-domains", "#power-domain-cells"},
+    reference_rule{"pwms", "#pwm-cells"},
+    reference_rule{"remote-endpoint", ""},
+    reference_rule{"resets", "#reset-cells"},
+    reference_rule{"sound-dai", "#sound-dai-cells"},
+    reference_rule{"target", ""},
+    reference_rule{"thermal-sensors", "#thermal-sensor-cells"},
+};
+
+auto find_rule(std::string_view name) noexcept -> std::optional<reference_rule> {
+    for (auto &&rule : reference_rules)
+        if (rule.name == name)
+            return rule;
+
+    if (name.ends_with("-supply"))
+        return reference_rule{name, ""};
+
+    if (name.ends_with("-gpios") || name.ends_with("-gpio"))
+        return reference_rule{name, "#gpio-cells"};
+
+    constexpr std::string_view pinctrl = "pinctrl-";
+    if (name.size() > pinctrl.size() && name.starts_with(pinctrl) && name[pinctrl.size()] >= '0' && name[pinctrl.size()] <= '9')
+        return reference_rule{name, ""};
+
+    return {};
+}
+
+auto cell(std::string_view data, const std::size_t i) noexcept -> u32 {
+    return read_data_32be<u32>(data.data() + i * 4);
+}
+} // namespace
+
+void fdt::phandle_index::update(const tree &value) {
+    if (m_node_count == value.nodes.size() && m_property_count == value.properties.size())
+        return;
+
+    if (m_node_count > value.nodes.size() || m_property_count > value.properties.size())
+        *this = {};
+
+    const auto first_property = static_cast<index>(m_property_count);
+    m_node_count = value.nodes.size();
+    m_property_count = value.properties.size();
+    m_users.resize(m_node_count);
+
+    // rules are matched once per distinct name
+    for (auto id = static_cast<name_id>(m_rules.size()); id < value.names.size(); ++id) {
+        const auto rule = find_rule(value.names.name(id));
+        m_rules.emplace_back(rule ? std::optional(rule->cells) : std::nullopt);
+    }
+
+    std::vector<u32> added;
+    for (auto &&name : {"phandle", "linux,phandle"}) {
+        const auto id = value.names.find(name);
+        if (!id)
+            continue;
+
+        for (auto property = first_property; property < value.properties.size(); ++property)
+            if (const auto &entry = value.properties[property]; entry.name == id.value() && 4 == entry.data.size())
+                if (m_nodes.emplace(cell(entry.data, 0), entry.node).second)
+                    added.emplace_back(cell(entry.data, 0));
+    }
+
+    std::vector<index> found;
+    for (auto property = first_property; property < value.properties.size(); ++property) {
+        found.clear();
+        if (const auto missing = walk(value, property, found))
+            m_waiting.emplace(missing.value(), property);
+
+        m_targets.insert(m_targets.end(), found.begin(), found.end());
+        m_target_offsets.emplace_back(static_cast<u32>(m_targets.size()));
+        link(property, found);
+    }
+
+    // properties that stopped at one of the new phandles continue, the walk repeats the
+    // targets they already have
+    for (auto &&phandle : added) {
+        const auto [begin, end] = m_waiting.equal_range(phandle);
+        std::vector<index> resumed;
+        for (auto iter = begin; iter != end; ++iter)
+            resumed.emplace_back(iter->second);
+        m_waiting.erase(begin, end);
+
+        for (auto &&property : resumed) {
+            const auto known = targets(property).size();
+            found.clear();
+            if (const auto missing = walk(value, property, found))
+                m_waiting.emplace(missing.value(), property);
+
+            link(property, std::span(found).subspan(known));
+            m_late_targets[property] = found;
+        }
+    }
+}
+
+auto fdt::phandle_index::walk(const tree &value, const index property, std::vector<index> &out) const -> std::optional<u32> {
+    const auto &entry = value.properties[property];
+    const auto &rule = m_rules[entry.name];
+    const auto count = entry.data.size() / 4;
+
+    for (std::size_t i = 0; rule && i < count;) {
+        const auto phandle = cell(entry.data, i);
+        const auto target = find(phandle);
+        if (npos == target)
+            return phandle; // without the provider the size of its specifier is unknown
+
+        // a property pointing twice at the same node is listed once
+        if (std::find(out.begin(), out.end(), target) == out.end())
+            out.emplace_back(target);
+
+        auto args = 0u;
+        if (!rule->empty())
+            if (const auto cells = find_property(value, target, rule.value()); cells && 4 == cells->data.size())
+                args = cell(cells->data, 0);
+
+        i += 1 + args;
+    }
+
+    return {};
+}
+
+void fdt::phandle_index::link(const index property, std::span<const index> targets) {
+    for (auto &&target : targets)
+        m_users[target].emplace_back(property);
+}
+
+auto fdt::phandle_index::find(const u32 phandle) const noexcept -> index {
+    const auto iter = m_nodes.find(phandle);
+    return m_nodes.end() == iter ? npos : iter->second;
+}
+
+auto fdt::phandle_index::targets(const index property) const noexcept -> std::span<const index> {
+    if (property + 1 >= m_target_offsets.size())
+        return {};
+
+    if (!m_late_targets.empty())
+        if (const auto iter = m_late_targets.find(property); m_late_targets.end() != iter)
+            return iter->second;
+
+    return std::span(m_targets).subspan(m_target_offsets[property], m_target_offsets[property + 1] - m_target_offsets[property]);
+}
+
+auto fdt::phandle_index::users(const index node) const noexcept -> std::span<const index> {
+    if (node >= m_users.size())
+        return {};
+
+    return m_users[node];
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <fdt/fdt-tree.hpp>
+#include <integer-types.hpp>
+
+#include <optional>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace fdt {
+
+// phandle -> node, the nodes every property points to and, reversed, the properties pointing
+// at every node; specifier lists (clocks, *-gpios, ...) are walked using the #*-cells of
+// each provider
+class phandle_index {
+public:
+    // indexes what the tree gained since the last call (expanded lazy nodes); trees only
+    // grow at the end, a smaller one is indexed from scratch
+    void update(const tree &value);
+
+    auto find(u32 phandle) const noexcept -> index;
+    auto targets(index property) const noexcept -> std::span<const index>;
+    auto users(index node) const noexcept -> std::span<const index>;
+
+private:
+    // the nodes a property points at, stops at the first phandle that is not known yet and
+    // returns it, its provider decides how many cells follow
+    auto walk(const tree &value, index property, std::vector<index> &out) const -> std::optional<u32>;
+    void link(index property, std::span<const index> targets);
+
+private:
+    std::unordered_map<u32, index> m_nodes;
+    std::vector<std::optional<std::string_view>> m_rules; // per name, #*-cells of the provider
+
+    // per property ranges into the flat array: [offsets[i], offsets[i + 1])
+    std::vector<u32> m_target_offsets{0};
+    std::vector<index> m_targets;
+    // properties resolved further once a provider got parsed, and those still waiting for one
+    std::unordered_map<index, std::vector<index>> m_late_targets;
+    std::unordered_multimap<u32, index> m_waiting;
+
+    std::vector<std::vector<index>> m_users; // per node
+
+    std::size_t m_node_count{0};
+    std::size_t m_property_count{0};
+};
+
+} // namespace fdt
@@ -1,32 +1,219 @@
 #pragma once
 
-#include <string>
-#include <types.hpp>
-#include <QHash>
-
-enum class property_type {
-    hex,
-    number,
-    string,
-    multiline,
-    guess,
-};
+#include <integer-types.hpp>
+
+#include <algorithm>
+#include <array>
+#include <string_view>
+
+namespace fdt {
 
-enum class word_size {
-    _8,
-    _16,
-    _32,
-    _64,
-    custom,
+enum class property_type : u8 {
+    guess,     // decided from the value
+    empty,     // boolean property without a value
+    number,    // a single cell shown in decimal: phandles, #*-cells
+    hex,       // 32-bit big-endian cells
+    bytes,     // byte string
+    string,    // a single NUL terminated string
+    multiline, // NUL separated string list
 };
 
-struct property_info {
-    property_type type{property_type::guess};
-    word_size word{word_size::_8};
+namespace detail {
+struct name_rule {
+    std::string_view name;
+    property_type type;
 };
 
-const static QHash<string, property_info> property_map = {
-    {"compatible", {property_type::multiline, word_size::custom}},
-    {"phandle", {property_type::number, word_size::_32}},
-    {"pinctrl-names", {property_type::multiline, word_size::custom}},
+constexpr auto exact_rules = [] {
+    using enum property_type;
+    std::array ret{
+        // strings and string lists
+        name_rule{"algo", string},
+        name_rule{"arch", string},
+        name_rule{"bootargs", string},
+        name_rule{"compatible", multiline},
+        name_rule{"compression", string},
+        name_rule{"default", string},
+        name_rule{"description", string},
+        name_rule{"device_type", string},
+        name_rule{"dr_mode", string},
+        name_rule{"enable-method", string},
+        name_rule{"fdt", multiline},
+        name_rule{"firmware", string},
+        name_rule{"kernel", string},
+        name_rule{"label", string},
+        name_rule{"linux,stdout-path", string},
+        name_rule{"loadables", multiline},
+        name_rule{"method", string},
+        name_rule{"model", string},
+        name_rule{"name", string},
+        name_rule{"os", string},
+        name_rule{"phy-connection-type", string},
+        name_rule{"phy-mode", string},
+        name_rule{"ramdisk", string},
+        name_rule{"regulator-name", string},
+        name_rule{"status", string},
+        name_rule{"stdout-path", string},
+        name_rule{"target-path", string},
+        name_rule{"type", string},
+        // single cells
+        name_rule{"bus-frequency", number},
+        name_rule{"clock-frequency", number},
+        name_rule{"cpu", number},
+        name_rule{"current-speed", number},
+        name_rule{"interrupt-parent", number},
+        name_rule{"linux,code", number},
+        name_rule{"linux,phandle", number},
+        name_rule{"next-level-cache", number},
+        name_rule{"phandle", number},
+        name_rule{"reg-io-width", number},
+        name_rule{"reg-shift", number},
+        name_rule{"target", number},
+        name_rule{"timebase-frequency", number},
+        name_rule{"timestamp", number},
+        // cell arrays
+        name_rule{"assigned-clock-parents", hex},
+        name_rule{"assigned-clock-rates", hex},
+        name_rule{"assigned-clocks", hex},
+        name_rule{"bus-range", hex},
+        name_rule{"clocks", hex},
+        name_rule{"cpu-release-addr", hex},
+        name_rule{"data-offset", hex},
+        name_rule{"data-position", hex},
+        name_rule{"data-size", hex},
+        name_rule{"dma-ranges", hex},
+        name_rule{"dmas", hex},
+        name_rule{"entry", hex},
+        name_rule{"interrupt-map", hex},
+        name_rule{"interrupt-map-mask", hex},
+        name_rule{"interrupts", hex},
+        name_rule{"interrupts-extended", hex},
+        name_rule{"iommus", hex},
+        name_rule{"linux,initrd-end", hex},
+        name_rule{"linux,initrd-start", hex},
+        name_rule{"load", hex},
+        name_rule{"mboxes", hex},
+        name_rule{"memory-region", hex},
+        name_rule{"nvmem-cells", hex},
+        name_rule{"operating-points", hex},
+        name_rule{"operating-points-v2", hex},
+        name_rule{"phys", hex},
+        name_rule{"power-domains", hex},
+        name_rule{"ranges", hex},
+        name_rule{"reg", hex},
+        name_rule{"resets", hex},
+        // raw bytes
+        name_rule{"data", bytes},
+        name_rule{"local-mac-address", bytes},
+        name_rule{"mac-address", bytes},
+        name_rule{"value", bytes},
+    };
+    std::ranges::sort(ret, {}, &name_rule::name);
+    return ret;
+}();
+
+constexpr std::array suffix_rules{
+    name_rule{"-names", property_type::multiline},
+    name_rule{"-gpios", property_type::hex},
+    name_rule{"-gpio", property_type::hex},
+    name_rule{"-map", property_type::hex},
+    name_rule{"-mask", property_type::hex},
+    name_rule{"-supply", property_type::number},
+    name_rule{"-parent", property_type::number},
+    name_rule{"-frequency", property_type::number},
+    name_rule{"-microvolt", property_type::number},
+    name_rule{"-microamp", property_type::number},
+    name_rule{"-us", property_type::number},
+    name_rule{"-ms", property_type::number},
 };
+
+constexpr auto is_printable(const char value) noexcept {
+    return value >= 0x20 && value < 0x7f;
+}
+} // namespace detail
+
+// type implied by a property name, from the devicetree specification and common bindings
+constexpr auto classify(const std::string_view name) noexcept -> property_type {
+    const auto &rules = detail::exact_rules;
+    const auto iter = std::ranges::lower_bound(rules, name, {}, &detail::name_rule::name);
+    if (iter != rules.end() && iter->name == name)
+        return iter->type;
+
+    if (name.starts_with('#') && name.ends_with("-cells"))
+        return property_type::number;
+
+    // pinctrl-0, pinctrl-1, ... hold lists of phandles
+    constexpr std::string_view pinctrl = "pinctrl-";
+    if (name.size() > pinctrl.size() && name.starts_with(pinctrl) && name[pinctrl.size()] >= '0' && name[pinctrl.size()] <= '9')
+        return property_type::hex;
+
+    for (auto &&rule : detail::suffix_rules)
+        if (name.ends_with(rule.name))
+            return rule.type;
+
+    return property_type::guess;
+}
+
+// checks the named type against the value and settles guesses, done once per property at load
+constexpr auto resolve(const property_type type, const std::string_view data) noexcept -> property_type {
+    if (data.empty())
+        return property_type::empty;
+
+    const auto cells = 0 == data.size() % 4;
+
+    auto strings = [&data]() {
+        if ('\0' != data.back() || '\0' == data.front())
+            return property_type::guess;
+
+        auto count = 0;
+        for (std::size_t i = 0; i < data.size(); ++i) {
+            if ('\0' == data[i]) {
+                // empty strings in the middle are more likely binary data
+                if (i + 1 < data.size() && '\0' == data[i + 1])
+                    return property_type::guess;
+                ++count;
+            } else if (!detail::is_printable(data[i]))
+                return property_type::guess;
+        }
+
+        return 1 == count ? property_type::string : property_type::multiline;
+    };
+
+    switch (type) {
+        case property_type::number:
+            if (4 == data.size())
+                return type;
+            break;
+        case property_type::hex:
+            if (cells)
+                return type;
+            return property_type::bytes;
+        case property_type::string:
+        case property_type::multiline:
+            // the value decides between one string and a list, a declared string may hold several
+            if (const auto value = strings(); property_type::guess != value)
+                return value;
+            break;
+        case property_type::bytes:
+            return type;
+        case property_type::empty:
+        case property_type::guess:
+            break;
+    }
+
+    if (const auto value = strings(); property_type::guess != value)
+        return value;
+
+    return cells ? property_type::hex : property_type::bytes;
+}
+
+static_assert(property_type::number == classify("#address-cells"));
+static_assert(property_type::multiline == classify("clock-names"));
+static_assert(property_type::hex == classify("pinctrl-0"));
+static_assert(property_type::multiline == classify("pinctrl-names"));
+static_assert(property_type::hex == classify("reset-gpios"));
+static_assert(property_type::guess == classify("vendor,custom"));
+static_assert(property_type::multiline == resolve(property_type::string, std::string_view("okay\0disabled", 14)));
+static_assert(property_type::string == resolve(property_type::multiline, std::string_view("clk\0", 4)));
+
+} // namespace fdt
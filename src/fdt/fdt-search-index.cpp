@@ -0,0 +1,85 @@
+#include "fdt-search-index.hpp"
+
+#include <algorithm>
+
+auto fdt::search_index::update(const tree &value, const render &node_text, const render &property_text, const std::atomic_bool &cancelled) -> bool {
+    if (m_nodes == value.nodes.size() && m_properties == value.properties.size())
+        return true;
+
+    // results of the last query do not cover the new entries
+    m_query = {};
+    m_matches.clear();
+
+    for (; m_nodes < value.nodes.size(); ++m_nodes) {
+        if (cancelled)
+            return false;
+
+        append(node_text(m_nodes), m_nodes);
+    }
+
+    for (; m_properties < value.properties.size(); ++m_properties) {
+        if (cancelled)
+            return false;
+
+        append(property_text(m_properties), value.properties[m_properties].node);
+    }
+
+    return true;
+}
+
+auto fdt::search_index::match(const string &query, std::vector<u8> &found, const std::atomic_bool &cancelled) -> bool {
+    std::vector<u32> matches;
+
+    auto hit = [&](const u32 entry) {
+        matches.emplace_back(entry);
+        found[m_owner[entry]] = 1;
+    };
+
+    if (!m_query.isNull() && query.contains(m_query)) {
+        for (auto &&entry : m_matches) {
+            if (cancelled)
+                return false;
+
+            if (text_of(entry).contains(query))
+                hit(entry);
+        }
+    } else {
+        const auto text = QStringView(m_text);
+        for (qsizetype from = 0;;) {
+            if (cancelled)
+                return false;
+
+            const auto position = text.indexOf(query, from);
+            if (-1 == position)
+                break;
+
+            // the remaining occurrences within a matched entry are not interesting
+            const auto entry = entry_at(position);
+            if (position + query.size() < m_offsets[entry + 1]) {
+                hit(entry);
+                from = m_offsets[entry + 1];
+            } else
+                from = position + 1;
+        }
+    }
+
+    m_query = query;
+    m_matches = std::move(matches);
+    return true;
+}
+
+auto fdt::search_index::append(const string &text, const index node) -> void {
+    m_text += text;
+    m_text += QChar(0);
+    m_offsets.emplace_back(static_cast<u32>(m_text.size()));
+    m_owner.emplace_back(node);
+}
+
+auto fdt::search_index::entry_at(const qsizetype position) const noexcept -> u32 {
+    const auto iter = std::upper_bound(m_offsets.begin(), m_offsets.end(), static_cast<u32>(position));
+    return static_cast<u32>(std::distance(m_offsets.begin(), iter)) - 1;
+}
+
+auto fdt::search_index::text_of(const u32 entry) const noexcept -> QStringView {
+    return QStringView(m_text).mid(m_offsets[entry], m_offsets[entry + 1] - m_offsets[entry] - 1);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <fdt/fdt-tree.hpp>
+#include <types.hpp>
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+namespace fdt {
+
+// rendered text of every node and property of a tree, kept in a single arena so a
+// query is one linear scan; entries are appended as the tree grows (lazy nodes)
+class search_index {
+public:
+    using render = std::function<string(index)>;
+
+    // indexes nodes and properties added since the last update, a cancelled
+    // update is resumed by the next call
+    auto update(const tree &value, const render &node_text, const render &property_text, const std::atomic_bool &cancelled) -> bool;
+
+    // sets found[node] for every node owning a matching entry, a query that contains
+    // the previous one only rechecks the entries matched last time
+    auto match(const string &query, std::vector<u8> &found, const std::atomic_bool &cancelled) -> bool;
+
+private:
+    auto append(const string &text, index node) -> void;
+    auto entry_at(qsizetype position) const noexcept -> u32;
+    auto text_of(u32 entry) const noexcept -> QStringView;
+
+private:
+    string m_text;                  // entries separated by a NUL character
+    std::vector<u32> m_offsets{0};  // entry i spans [m_offsets[i], m_offsets[i + 1] - 1)
+    std::vector<index> m_owner;     // node of every entry
+    index m_nodes{0};
+    index m_properties{0};
+
+    string m_query; // last query and the entries it matched
+    std::vector<u32> m_matches;
+};
+
+} // namespace fdt
@@ -0,0 +1,402 @@
+#include "fdt-tree-model.hpp"
+
+#include <fdt/fdt-cells.hpp>
+#include <fdt/fdt-diff.hpp>
+
+#include <algorithm>
+
+static_assert(sizeof(quintptr) >= sizeof(u64), "model indexes pack the tree key and the entry into quintptr");
+
+namespace {
+constexpr auto PROPERTY_BIT = quintptr{1} << 31;
+constexpr auto VALUE_MASK = PROPERTY_BIT - 1;
+} // namespace
+
+auto tree_info::name_string(const fdt::name_id id) -> const string & {
+    if (id >= name_strings.size())
+        name_strings.resize(tree.names.size());
+
+    auto &ret = name_strings[id];
+    if (ret.isNull())
+        ret = to_string(tree.names.name(id));
+
+    return ret;
+}
+
+auto tree_info::node_name(const fdt::index id) const -> string {
+    const auto &node = tree.nodes[id];
+    return fdt::npos == node.parent ? name : to_string(node.name);
+}
+
+auto tree_info::set_hidden(std::vector<u8> &&value) -> void {
+    std::vector<fdt::index> changed;
+    for (fdt::index i = 0; i < value.size() && i < hidden.size(); ++i)
+        if (hidden[i] != value[i])
+            changed.emplace_back(i);
+
+    drop_dts(changed);
+    hidden = std::move(value);
+}
+
+auto tree_info::expanded(std::span<const fdt::index> nodes) -> void {
+    drop_dts(nodes);
+    if (provisional.empty())
+        return;
+
+    phandles.update(tree);
+
+    std::vector<fdt::index> changed;
+    std::erase_if(provisional, [&](const fdt::index node) {
+        const auto before = tree.nodes[node].cells.interrupt;
+        const auto &after = fdt::resolve_cells(tree, phandles, node);
+        if (!after.interrupt_resolved)
+            return false;
+
+        if (before != after.interrupt)
+            changed.emplace_back(node);
+
+        return true;
+    });
+
+    drop_dts(changed);
+}
+
+auto tree_info::drop_dts(std::span<const fdt::index> nodes) -> void {
+    if (nodes.empty() || dts.isEmpty())
+        return;
+
+    // climbing stops at an already dropped branch
+    std::vector<u8> stale(tree.nodes.size(), 0);
+    for (auto &&node : nodes) {
+        for (auto id = node; fdt::npos != id && !stale[id]; id = tree.nodes[id].parent) {
+            stale[id] = 1;
+            dts.remove(id);
+        }
+    }
+}
+
+fdt::tree_model::tree_model(QObject *parent)
+        : QAbstractItemModel(parent)
+        , m_node_icon(QIcon::fromTheme("folder-open"))
+        , m_property_icon(QIcon::fromTheme("flag-green")) {
+}
+
+auto fdt::tree_model::load(tree &&value, string &&name, string &&id) -> QModelIndex {
+    auto info = std::make_shared<tree_info>();
+    info->id = std::move(id);
+    info->name = std::move(name);
+    info->tree = std::move(value);
+    info->hidden.assign(info->tree.nodes.size(), 0);
+    info->phandles.update(info->tree);
+    info->key = static_cast<u32>(m_keys.size());
+
+    // reloading replaces the tree in place
+    auto row = row_of(info->id);
+    if (-1 != row) {
+        beginRemoveRows({}, row, row);
+        m_keys[m_files[row]->key] = nullptr;
+        m_files.erase(m_files.begin() + row);
+        endRemoveRows();
+    } else
+        row = static_cast<int>(m_files.size());
+
+    info->row = row;
+
+    beginInsertRows({}, row, row);
+    m_keys.emplace_back(info.get());
+    m_files.insert(m_files.begin() + row, std::move(info));
+    endInsertRows();
+
+    return index(row, 0);
+}
+
+auto fdt::tree_model::placeholder(string &&name, string &&id) -> QModelIndex {
+    tree value;
+    value.nodes.emplace_back();
+
+    const auto ret = load(std::move(value), std::move(name), std::move(id));
+    m_files[ret.row()]->pending = true;
+    return ret;
+}
+
+auto fdt::tree_model::find(const string &id) const noexcept -> tree_info * {
+    const auto row = row_of(id);
+    return -1 == row ? nullptr : m_files[row].get();
+}
+
+auto fdt::tree_model::reload(const string &id, tree &&value) -> bool {
+    const auto row = row_of(id);
+    if (-1 == row)
+        return false;
+
+    // a new tree_info takes over the key, searches still running keep reading the previous one
+    auto &previous = *m_files[row];
+    auto info = std::make_shared<tree_info>();
+    info->id = previous.id;
+    info->name = previous.name;
+    info->tree = std::move(value);
+    info->key = previous.key;
+    info->row = previous.row;
+
+    const auto mapping = map_entries(previous.tree, info->tree);
+    info->phandles.update(info->tree);
+
+    // rendered text also depends on cell counts from outside a subtree, the parent's
+    // #address-cells or an interrupt parent elsewhere; a node whose plan changed is
+    // rendered again together with its ancestors
+    std::vector<u8> stale(previous.tree.nodes.size(), 0);
+    for (fdt::index node = 0; node < mapping.nodes.size(); ++node) {
+        const auto &before = previous.tree.nodes[node].cells;
+        if (npos == mapping.nodes[node] || !before.resolved || stale[node])
+            continue;
+
+        const auto &after = resolve_cells(info->tree, info->phandles, mapping.nodes[node]);
+        if (before.interrupt_resolved && same_entries(before, after))
+            continue;
+
+        for (auto id = node; npos != id && !stale[id]; id = previous.tree.nodes[id].parent)
+            stale[id] = 1;
+    }
+
+    info->hidden.assign(info->tree.nodes.size(), 0);
+    for (fdt::index node = 0; node < mapping.nodes.size() && node < previous.hidden.size(); ++node) {
+        const auto target = mapping.nodes[node];
+        if (npos == target)
+            continue;
+
+        info->hidden[target] = previous.hidden[node];
+        if (mapping.unchanged[node] && !stale[node] && previous.dts.contains(node)) {
+            const auto size = previous.dts.object(node)->size();
+            info->dts.insert(target, previous.dts.take(node), size);
+        }
+    }
+
+    emit layoutAboutToBeChanged();
+
+    const auto indexes = persistentIndexList();
+    QModelIndexList from;
+    QModelIndexList to;
+    for (auto &&index : indexes) {
+        if (this->info(index) != &previous)
+            continue;
+
+        const auto value = entry_at(index);
+        const auto target = entry_type::node == value.type ? mapping.nodes[value.value] : mapping.properties[value.value];
+        from.append(index);
+        to.append(npos == target ? QModelIndex() : index_of(*info, {value.type, target}));
+    }
+
+    m_keys[info->key] = info.get();
+    m_files[row] = std::move(info);
+    changePersistentIndexList(from, to);
+
+    emit layoutChanged();
+    return true;
+}
+
+auto fdt::tree_model::drop(const string &id) -> void {
+    const auto row = row_of(id);
+    if (-1 == row)
+        return;
+
+    beginRemoveRows({}, row, row);
+    m_keys[m_files[row]->key] = nullptr;
+    m_files.erase(m_files.begin() + row);
+    for (auto i = row; i < static_cast<int>(m_files.size()); ++i)
+        m_files[i]->row = i;
+    endRemoveRows();
+}
+
+auto fdt::tree_model::clear() -> void {
+    beginResetModel();
+    m_files.clear();
+    std::ranges::fill(m_keys, nullptr);
+    endResetModel();
+}
+
+auto fdt::tree_model::expand_all(const QModelIndex &index) -> void {
+    const auto info = this->info(index);
+    const auto value = entry_at(index);
+    if (nullptr == info || entry_type::property == value.type || info->tree.deferred.empty())
+        return;
+
+    auto &tree = info->tree;
+    std::vector<fdt::index> expanded;
+
+    std::vector<fdt::index> pending{value.value};
+    while (!pending.empty()) {
+        const auto id = pending.back();
+        pending.pop_back();
+
+        if (npos != tree.nodes[id].deferred) {
+            if (expanded.empty())
+                emit layoutAboutToBeChanged();
+
+            expanded.emplace_back(id);
+            commit_expansion(tree, prepare_expansion(tree, id));
+        }
+
+        for (auto &&child : tree.children(tree.nodes[id]))
+            if (entry_type::node == child.type)
+                pending.emplace_back(child.value);
+    }
+
+    if (expanded.empty())
+        return;
+
+    // existing rows keep their position, only previously empty nodes gain children; their
+    // placeholders in the cached DTS are replaced
+    info->hidden.resize(tree.nodes.size(), 0);
+    info->expanded(expanded);
+    emit layoutChanged();
+}
+
+auto fdt::tree_model::info(const QModelIndex &index) const noexcept -> tree_info * {
+    if (!index.isValid())
+        return nullptr;
+
+    const auto key = static_cast<std::size_t>(index.internalId() >> 32);
+    return key < m_keys.size() ? m_keys[key] : nullptr;
+}
+
+auto fdt::tree_model::entry_at(const QModelIndex &index) const noexcept -> entry {
+    const auto id = index.internalId();
+    return {(id & PROPERTY_BIT) ? entry_type::property : entry_type::node, static_cast<fdt::index>(id & VALUE_MASK)};
+}
+
+auto fdt::tree_model::index_of(const tree_info &info, const entry value) const noexcept -> QModelIndex {
+    const auto &tree = info.tree;
+    if (entry_type::property == value.type)
+        return createIndex(static_cast<int>(tree.properties[value.value].row), 0, pack(info, value));
+
+    const auto &node = tree.nodes[value.value];
+    const auto row = npos == node.parent ? info.row : static_cast<int>(node.row);
+    return createIndex(row, 0, pack(info, value));
+}
+
+QModelIndex fdt::tree_model::index(int row, int column, const QModelIndex &parent) const {
+    if (!hasIndex(row, column, parent))
+        return {};
+
+    if (!parent.isValid())
+        return createIndex(row, column, pack(*m_files[row], {entry_type::node, 0}));
+
+    const auto info = this->info(parent);
+    const auto &node = info->tree.nodes[entry_at(parent).value];
+    return createIndex(row, column, pack(*info, info->tree.children(node)[row]));
+}
+
+QModelIndex fdt::tree_model::parent(const QModelIndex &child) const {
+    const auto info = this->info(child);
+    if (nullptr == info)
+        return {};
+
+    const auto &tree = info->tree;
+    const auto value = entry_at(child);
+    const auto parent = entry_type::node == value.type ? tree.nodes[value.value].parent : tree.properties[value.value].node;
+    if (npos == parent)
+        return {};
+
+    const auto &node = tree.nodes[parent];
+    const auto row = npos == node.parent ? info->row : static_cast<int>(node.row);
+    return createIndex(row, 0, pack(*info, {entry_type::node, parent}));
+}
+
+int fdt::tree_model::rowCount(const QModelIndex &parent) const {
+    if (parent.column() > 0)
+        return 0;
+
+    if (!parent.isValid())
+        return static_cast<int>(m_files.size());
+
+    const auto value = entry_at(parent);
+    if (entry_type::property == value.type)
+        return 0;
+
+    return static_cast<int>(info(parent)->tree.nodes[value.value].row_count);
+}
+
+int fdt::tree_model::columnCount(const QModelIndex &) const {
+    return 1;
+}
+
+bool fdt::tree_model::hasChildren(const QModelIndex &parent) const {
+    return canFetchMore(parent) || QAbstractItemModel::hasChildren(parent);
+}
+
+bool fdt::tree_model::canFetchMore(const QModelIndex &parent) const {
+    const auto info = this->info(parent);
+    const auto value = entry_at(parent);
+    return nullptr != info && entry_type::node == value.type && (info->pending || npos != info->tree.nodes[value.value].deferred);
+}
+
+void fdt::tree_model::fetchMore(const QModelIndex &parent) {
+    if (!canFetchMore(parent))
+        return;
+
+    // the tree replaces the whole tree_info, which is not done while a view is expanding it
+    auto &info = *this->info(parent);
+    if (info.pending) {
+        emit fetch_requested(info.id);
+        return;
+    }
+
+    const auto node = entry_at(parent).value;
+    const auto rows = prepare_expansion(info.tree, node);
+    info.hidden.resize(info.tree.nodes.size(), 0);
+
+    // plans are looked up again once the rows are attached
+    if (0 == rows.row_count) {
+        commit_expansion(info.tree, rows);
+        info.expanded({&node, 1});
+        return;
+    }
+
+    beginInsertRows(parent, 0, static_cast<int>(rows.row_count) - 1);
+    commit_expansion(info.tree, rows);
+    endInsertRows();
+    info.expanded({&node, 1});
+}
+
+QVariant fdt::tree_model::data(const QModelIndex &index, int role) const {
+    const auto info = this->info(index);
+    if (nullptr == info)
+        return {};
+
+    const auto value = entry_at(index);
+    const auto is_node = entry_type::node == value.type;
+
+    switch (role) {
+        case Qt::DisplayRole:
+            if (is_node)
+                return info->node_name(value.value);
+            return info->name_string(info->tree.properties[value.value].name);
+        case Qt::DecorationRole:
+            return is_node ? m_node_icon : m_property_icon;
+        case QT_ROLE_FILEPATH:
+            return info->id;
+        case QT_ROLE_NODETYPE:
+            return QVariant::fromValue(is_node ? NodeType::Node : NodeType::Property);
+    }
+
+    return {};
+}
+
+auto fdt::tree_model::pack(const tree_info &info, const entry value) const noexcept -> quintptr {
+    const auto id = (static_cast<quintptr>(info.key) << 32) | static_cast<quintptr>(value.value);
+    return entry_type::property == value.type ? id | PROPERTY_BIT : id;
+}
+
+auto fdt::tree_model::row_of(const string &id) const noexcept -> int {
+    const auto iter = std::ranges::find_if(m_files, [&id](auto &&info) { return info->id == id; });
+    return m_files.end() == iter ? -1 : static_cast<int>(std::distance(m_files.begin(), iter));
+}
+
+bool fdt::tree_filter_model::filterAcceptsRow(int source_row, const QModelIndex &source_parent) const {
+    const auto model = static_cast<const tree_model *>(sourceModel());
+    const auto index = model->index(source_row, 0, source_parent);
+    const auto info = model->info(index);
+    const auto value = model->entry_at(index);
+
+    return nullptr == info || entry_type::property == value.type || !info->hidden[value.value];
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <fdt/fdt-address-map.hpp>
+#include <fdt/fdt-phandles.hpp>
+#include <fdt/fdt-property-types.hpp>
+#include <fdt/fdt-search-index.hpp>
+#include <fdt/fdt-tree.hpp>
+#include <types.hpp>
+
+#include <QAbstractItemModel>
+#include <QCache>
+#include <QIcon>
+#include <QMetaType>
+#include <QSortFilterProxyModel>
+
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+constexpr auto QT_ROLE_FILEPATH = Qt::UserRole + 1;
+constexpr auto QT_ROLE_NODETYPE = Qt::UserRole + 2;
+
+enum class NodeType {
+    Node,
+    Property
+};
+
+Q_DECLARE_METATYPE(NodeType)
+
+inline auto to_string(std::string_view value) -> string {
+    return string::fromUtf8(value.data(), value.size());
+}
+
+// characters of rendered DTS kept per file
+constexpr auto DTS_CACHE_SIZE = 16 * 1024 * 1024;
+
+struct tree_info {
+    string id;
+    string name;
+    fdt::tree tree;
+    std::vector<string> name_strings; // decoded once per interned name
+    std::vector<u8> hidden;           // per node, set from the results of fdt_content_match
+    fdt::search_index search;         // only touched by the search worker
+    QCache<fdt::index, string> dts{DTS_CACHE_SIZE}; // rendered subtrees, see fdt_view_dts
+    fdt::phandle_index phandles;      // built at load, extended once lazy nodes are parsed
+    std::optional<fdt::address_map> addresses; // see fdt_view_address_map
+    std::unordered_set<fdt::index> provisional; // rendered before their interrupt parent was parsed
+    u32 key{0};
+    int row{0};
+    bool pending{false}; // placeholder of a restored file until its tree is loaded
+
+    auto name_string(fdt::name_id id) -> const string &;
+    auto node_name(fdt::index id) const -> string;
+
+    // replaces the filter result, cached renderings of the branches that changed are dropped
+    auto set_hidden(std::vector<u8> &&value) -> void;
+    // drops the cached renderings of the nodes and of every ancestor, which include them
+    auto drop_dts(std::span<const fdt::index> nodes) -> void;
+    // after deferred nodes were parsed: their placeholders are dropped, and so is the text of
+    // provisional nodes whose interrupt parent showed up with other cell counts
+    auto expanded(std::span<const fdt::index> nodes) -> void;
+};
+
+namespace fdt {
+
+// exposes the loaded trees as top level rows, rows below are created on demand from the arena
+class tree_model : public QAbstractItemModel {
+    Q_OBJECT
+public:
+    tree_model(QObject *parent = nullptr);
+
+    auto load(tree &&value, string &&name, string &&id) -> QModelIndex;
+    // a file row without contents, expanding it asks for the tree with fetch_requested
+    auto placeholder(string &&name, string &&id) -> QModelIndex;
+    auto find(const string &id) const noexcept -> tree_info *;
+    // swaps in a newer version of a loaded tree; items of matching entries, and with them
+    // expansion and selection, are kept and unchanged subtrees keep their rendering
+    auto reload(const string &id, tree &&value) -> bool;
+    auto drop(const string &id) -> void;
+    auto clear() -> void;
+
+    // parses every deferred node below index, announced as a single layout change
+    auto expand_all(const QModelIndex &index) -> void;
+
+    auto info(const QModelIndex &index) const noexcept -> tree_info *;
+    auto entry_at(const QModelIndex &index) const noexcept -> entry;
+    auto index_of(const tree_info &info, entry value) const noexcept -> QModelIndex;
+    auto files() const noexcept -> const std::vector<std::shared_ptr<tree_info>> & { return m_files; }
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = {}) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = {}) const override;
+    int columnCount(const QModelIndex &parent = {}) const override;
+    bool hasChildren(const QModelIndex &parent = {}) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+signals:
+    void fetch_requested(const string &id);
+
+private:
+    auto pack(const tree_info &info, entry value) const noexcept -> quintptr;
+    auto row_of(const string &id) const noexcept -> int;
+
+private:
+    std::vector<std::shared_ptr<tree_info>> m_files; // shared with running searches
+    std::vector<tree_info *> m_keys;
+    QIcon m_node_icon;
+    QIcon m_property_icon;
+};
+
+// hides nodes rejected by the last search
+class tree_filter_model : public QSortFilterProxyModel {
+public:
+    using QSortFilterProxyModel::QSortFilterProxyModel;
+
+    void refresh() { invalidateFilter(); }
+
+protected:
+    bool filterAcceptsRow(int source_row, const QModelIndex &source_parent) const override;
+};
+
+} // namespace fdt
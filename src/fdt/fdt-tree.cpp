@@ -0,0 +1,417 @@
+#include "fdt-tree.hpp"
+
+#include <endian-conversions.hpp>
+#include <fdt/fdt-parser.hpp>
+
+#include <algorithm>
+
+namespace {
+using namespace std::string_view_literals;
+
+// FIT images with external data keep their payload behind the blob; data-position is absolute,
+// data-offset counts from the end of the blob rounded up to 4 bytes
+struct external_data {
+    std::string_view size;
+    std::string_view offset;
+    std::string_view position;
+
+    void take(const fdt_property &value) noexcept {
+        if (fdt::id(fdt::known_name::data_size) == value.id)
+            size = value.data;
+        if (fdt::id(fdt::known_name::data_offset) == value.id)
+            offset = value.data;
+        if (fdt::id(fdt::known_name::data_position) == value.id)
+            position = value.data;
+    }
+
+    // only the header of the payload is read, anything but a devicetree is left alone
+    auto locate(const fdt::tree &value, const char *fdt) const -> std::optional<fdt_span> {
+        if (4 != size.size() || (4 != offset.size() && 4 != position.size()))
+            return {};
+
+        const auto owner = std::ranges::find_if(value.blobs, [fdt](auto &&blob) {
+            return blob.data.data() <= fdt && fdt < blob.data.data() + blob.data.size();
+        });
+
+        if (value.blobs.end() == owner)
+            return {};
+
+        const auto available = owner->data.size() - static_cast<u64>(fdt - owner->data.data());
+        const auto end_of_blob = (u64{read_data_32be<fdt::header>(fdt).totalsize} + 3) & ~u64{3};
+        const auto begin = 4 == position.size() ? u64{read_data_32be<u32>(position.data())} : end_of_blob + read_data_32be<u32>(offset.data());
+        const auto length = u64{read_data_32be<u32>(size.data())};
+
+        if (begin > available || length > available - begin)
+            return {};
+
+        return fdt_parser::root_span(fdt + begin, length);
+    }
+};
+
+// appends the flat contents of a deferred node, the parser reports every child node as deferred
+class node_expander : public iface_fdt_generator {
+public:
+    node_expander(fdt::tree &target, const fdt::index node)
+            : m_tree(target)
+            , m_node(node)
+            , m_rows_begin(static_cast<u32>(target.rows.size())) {
+    }
+
+    void begin_node(std::string_view) noexcept final {}
+    void end_node() noexcept final {}
+
+    void insert_property(const fdt_property &value) noexcept final {
+        const auto id = static_cast<fdt::index>(m_tree.properties.size());
+        m_tree.properties.push_back({.name = value.id, .node = m_node, .row = row_count(), .type = fdt::resolve(m_tree.names.type(value.id), value.data), .data = value.data});
+        m_tree.rows.push_back({fdt::entry_type::property, id});
+        m_external.take(value);
+    }
+
+    void deferred_node(std::string_view name, const fdt_span &span) noexcept final {
+        const auto id = static_cast<fdt::index>(m_tree.nodes.size());
+        m_tree.nodes.push_back({.name = name, .parent = m_node, .row = row_count(), .deferred = static_cast<fdt::index>(m_tree.deferred.size()), .embedded = span.root});
+        m_tree.deferred.emplace_back(span);
+        m_tree.rows.push_back({fdt::entry_type::node, id});
+    }
+
+    auto result() const noexcept -> fdt::expansion {
+        return {m_node, m_rows_begin, row_count()};
+    }
+
+    auto external() const noexcept -> const external_data & {
+        return m_external;
+    }
+
+private:
+    auto row_count() const noexcept -> u32 {
+        return static_cast<u32>(m_tree.rows.size()) - m_rows_begin;
+    }
+
+private:
+    fdt::tree &m_tree;
+    const fdt::index m_node;
+    const u32 m_rows_begin;
+    external_data m_external;
+};
+
+constexpr auto mix(const u64 seed, const u64 value) noexcept -> u64 {
+    return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
+
+// resolves an absolute path one component at a time
+template <typename function>
+auto walk_path(std::string_view path, function &&child) noexcept -> fdt::index {
+    if (!path.starts_with('/'))
+        return fdt::npos;
+
+    fdt::index ret = 0;
+    while (!path.empty() && fdt::npos != ret) {
+        path.remove_prefix(1);
+        const auto size = std::min(path.find('/'), path.size());
+        if (size)
+            ret = child(ret, path.substr(0, size));
+        path.remove_prefix(size);
+    }
+
+    return ret;
+}
+
+// embedded blobs are only checked for a valid header, their contents are parsed once
+// the node is expanded
+struct defer_embedded {
+    void operator()(const fdt_property &property, auto &generator) const noexcept {
+        if (const auto span = fdt_parser::root_span(property.data.data(), property.data.size()))
+            generator.deferred_node(property.name, span.value());
+    }
+};
+
+auto lazy_special_properties() -> const fdt_special_properties<defer_embedded> & {
+    static const fdt_special_properties<defer_embedded> ret = {
+        {fdt::id(fdt::known_name::data), {}},
+    };
+
+    return ret;
+}
+} // namespace
+
+fdt::tree_builder::tree_builder(tree &target)
+        : m_tree(target) {
+}
+
+void fdt::tree_builder::begin_node(std::string_view name) noexcept {
+    const auto parent = m_stack.empty() ? npos : m_stack.back();
+
+    auto id = (npos == parent && !m_tree.nodes.empty()) ? 0 : find_child(parent, name);
+    if (npos == id)
+        id = create_node(parent, name);
+
+    m_stack.emplace_back(id);
+}
+
+void fdt::tree_builder::end_node() noexcept {
+    if (!m_stack.empty())
+        m_stack.pop_back();
+}
+
+void fdt::tree_builder::insert_property(const fdt_property &value) noexcept {
+    if (m_stack.empty())
+        return;
+
+    const auto id = static_cast<index>(m_tree.properties.size());
+    m_tree.properties.push_back({.name = value.id, .node = m_stack.back(), .type = resolve(m_tree.names.type(value.id), value.data), .data = value.data});
+    m_next_property.emplace_back();
+    append(m_stack.back(), {entry_type::property, id});
+}
+
+void fdt::tree_builder::deferred_node(std::string_view name, const fdt_span &span) noexcept {
+    if (m_stack.empty())
+        return;
+
+    const auto id = create_node(m_stack.back(), name);
+    m_tree.nodes[id].deferred = static_cast<index>(m_tree.deferred.size());
+    m_tree.nodes[id].embedded = span.root;
+    m_tree.deferred.emplace_back(span);
+}
+
+auto fdt::tree_builder::find_path(std::string_view path) const noexcept -> index {
+    if (m_tree.nodes.empty())
+        return npos;
+
+    return walk_path(path, [this](const index parent, std::string_view name) { return find_child(parent, name); });
+}
+
+auto fdt::tree_builder::find_property(const index node, const name_id name) const noexcept -> index {
+    for (auto child = m_first[node]; npos != child.value; child = next(child))
+        if (entry_type::property == child.type && m_tree.properties[child.value].name == name)
+            return child.value;
+
+    return npos;
+}
+
+auto fdt::tree_builder::path(const index node) const -> std::string {
+    return fdt::path(m_tree, node);
+}
+
+void fdt::tree_builder::enter(const index node) {
+    m_stack.assign(1, node);
+}
+
+void fdt::tree_builder::set_property(const fdt_property &value) noexcept {
+    if (m_stack.empty())
+        return;
+
+    const auto id = find_property(m_stack.back(), value.id);
+    if (npos == id)
+        return insert_property(value);
+
+    auto &property = m_tree.properties[id];
+    property.type = resolve(m_tree.names.type(value.id), value.data);
+    property.data = value.data;
+}
+
+void fdt::tree_builder::finalize() {
+    m_tree.rows.clear();
+    m_tree.rows.reserve(m_tree.nodes.size() + m_tree.properties.size());
+
+    for (index i = 0; i < m_tree.nodes.size(); ++i) {
+        auto &node = m_tree.nodes[i];
+        node.rows_begin = static_cast<u32>(m_tree.rows.size());
+        node.row_count = 0;
+
+        for (auto child = m_first[i]; npos != child.value; child = next(child)) {
+            if (entry_type::node == child.type)
+                m_tree.nodes[child.value].row = node.row_count;
+            else
+                m_tree.properties[child.value].row = node.row_count;
+
+            m_tree.rows.emplace_back(child);
+            ++node.row_count;
+        }
+    }
+
+    // a separate pass over the finished tree beats hashing every property as it arrives
+    update_hashes(m_tree);
+}
+
+auto fdt::tree_builder::create_node(const index parent, std::string_view name) -> index {
+    const auto id = static_cast<index>(m_tree.nodes.size());
+    m_tree.nodes.push_back({.name = name, .parent = parent});
+    m_first.emplace_back();
+    m_last.emplace_back();
+    m_next_node.emplace_back();
+
+    if (npos != parent) {
+        append(parent, {entry_type::node, id});
+        m_children.emplace(child_key{parent, name}, id);
+    }
+
+    return id;
+}
+
+auto fdt::tree_builder::find_child(const index parent, std::string_view name) const noexcept -> index {
+    if (npos == parent)
+        return npos;
+
+    const auto iter = m_children.find({parent, name});
+    return m_children.end() == iter ? npos : iter->second;
+}
+
+void fdt::tree_builder::append(const index parent, const entry value) {
+    if (npos == m_last[parent].value)
+        m_first[parent] = value;
+    else
+        next(m_last[parent]) = value;
+
+    m_last[parent] = value;
+}
+
+auto fdt::tree_builder::next(const entry value) -> entry & {
+    return entry_type::node == value.type ? m_next_node[value.value] : m_next_property[value.value];
+}
+
+auto fdt::tree_builder::next(const entry value) const -> const entry & {
+    return entry_type::node == value.type ? m_next_node[value.value] : m_next_property[value.value];
+}
+
+auto fdt::find_child(const tree &value, const index node, std::string_view name) noexcept -> index {
+    for (auto &&child : value.children(value.nodes[node]))
+        if (entry_type::node == child.type && value.nodes[child.value].name == name)
+            return child.value;
+
+    return npos;
+}
+
+auto fdt::find_path(const tree &value, std::string_view path) noexcept -> index {
+    if (value.nodes.empty())
+        return npos;
+
+    return walk_path(path, [&value](const index parent, std::string_view name) { return find_child(value, parent, name); });
+}
+
+auto fdt::find_property(const tree &value, const index node, std::string_view name) noexcept -> const property_entry * {
+    const auto id = value.names.find(name);
+    if (!id)
+        return nullptr;
+
+    for (auto &&child : value.children(value.nodes[node]))
+        if (entry_type::property == child.type && value.properties[child.value].name == id.value())
+            return &value.properties[child.value];
+
+    return nullptr;
+}
+
+auto fdt::path(const tree &value, const index node) -> std::string {
+    std::vector<std::string_view> names;
+    for (auto id = node; npos != id && npos != value.nodes[id].parent; id = value.nodes[id].parent)
+        names.emplace_back(value.nodes[id].name);
+
+    std::string ret;
+    for (auto iter = names.rbegin(); iter != names.rend(); ++iter)
+        ret.append("/").append(*iter);
+
+    return ret.empty() ? "/" : ret;
+}
+
+auto fdt::parse_tree(const blob &source, const parse_mode mode) -> std::optional<tree> {
+    tree ret;
+    ret.blobs.emplace_back(source);
+
+    if (parse_mode::lazy == mode) {
+        const auto span = fdt_parser::root_span(source.data.data(), source.data.size());
+        if (!span)
+            return {};
+
+        ret.nodes.push_back({.deferred = 0});
+        ret.deferred.emplace_back(span.value());
+        commit_expansion(ret, prepare_expansion(ret, 0));
+        return ret;
+    }
+
+    tree_builder builder(ret);
+
+    basic_fdt_parser parser(source.data.data(), source.data.size(), builder, ret.names, {}, lazy_special_properties());
+    if (!parser.is_valid())
+        return {};
+
+    for (index id = 0, count = static_cast<index>(ret.properties.size()); id < count; ++id) {
+        const auto &property = ret.properties[id];
+        if (fdt::id(known_name::data_size) != property.name)
+            continue;
+
+        external_data external;
+        for (auto &&name : {known_name::data_size, known_name::data_offset, known_name::data_position})
+            if (const auto found = builder.find_property(property.node, fdt::id(name)); npos != found)
+                external.take({.id = fdt::id(name), .data = ret.properties[found].data});
+
+        if (const auto span = external.locate(ret, source.data.data())) {
+            builder.enter(property.node);
+            builder.deferred_node("data"sv, span.value());
+        }
+    }
+
+    builder.finalize();
+    return ret;
+}
+
+auto fdt::prepare_expansion(tree &value, const index node) -> expansion {
+    const auto deferred = value.nodes[node].deferred;
+    if (npos == deferred)
+        return {};
+
+    value.nodes[node].deferred = npos;
+
+    const auto span = value.deferred[deferred];
+    node_expander expander(value, node);
+    basic_fdt_parser(span, expander, value.names, lazy_special_properties());
+
+    if (const auto external = expander.external().locate(value, span.fdt))
+        expander.deferred_node("data"sv, external.value());
+
+    return expander.result();
+}
+
+void fdt::commit_expansion(tree &value, const expansion &rows) noexcept {
+    if (npos == rows.node)
+        return;
+
+    value.hashes.clear(); // the node and all its ancestors changed
+
+    // a plan resolved while the node was deferred saw none of its properties
+    auto &node = value.nodes[rows.node];
+    node.rows_begin = rows.rows_begin;
+    node.row_count = rows.row_count;
+    node.cells = {};
+}
+
+void fdt::update_hashes(tree &value) {
+    const std::hash<std::string_view> hash;
+
+    std::vector<u64> names(value.names.size());
+    for (name_id id = 0; id < names.size(); ++id)
+        names[id] = hash(value.names.name(id));
+
+    // nodes are stored before their descendants, a reverse pass hashes every subtree before its parent
+    value.hashes.assign(value.nodes.size(), 0);
+    for (auto i = value.nodes.size(); i-- > 0;) {
+        const auto &node = value.nodes[i];
+        auto ret = hash(node.name);
+
+        // unparsed contents are covered by their raw structure block
+        if (npos != node.deferred) {
+            const auto &span = value.deferred[node.deferred];
+            ret = mix(ret, hash(std::string_view(span.fdt + span.begin, span.end - span.begin)));
+        }
+
+        for (auto &&child : value.children(node)) {
+            if (entry_type::node == child.type) {
+                ret = mix(ret, value.hashes[child.value]);
+                continue;
+            }
+
+            const auto &property = value.properties[child.value];
+            ret = mix(ret, mix(names[property.name], hash(property.data)));
+        }
+
+        value.hashes[i] = ret;
+    }
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <fdt/fdt-blob.hpp>
+#include <fdt/fdt-generator.hpp>
+#include <fdt/fdt-names.hpp>
+#include <integer-types.hpp>
+
+#include <limits>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace fdt {
+
+using index = u32;
+
+constexpr auto npos = std::numeric_limits<index>::max();
+
+enum class entry_type : u8 {
+    node,
+    property,
+};
+
+// a single row below a node, either one of its properties or one of its child nodes
+struct entry {
+    entry_type type{entry_type::node};
+    index value{npos};
+};
+
+// cell counts that split the reg, ranges and interrupts of a node into entries; filled on
+// first use from the parent's counts, see fdt::resolve_cells
+struct cell_plan {
+    u8 address{2};       // #address-cells of the parent, the reg and parent side of ranges
+    u8 size{1};          // #size-cells of the parent
+    u8 child_address{2}; // own #address-cells, the child side of ranges
+    u8 child_size{1};    // own #size-cells, the size of ranges
+    u8 interrupt{0};     // #interrupt-cells of the interrupt parent, 0 without one
+    u8 own_interrupt{0}; // own #interrupt-cells, 0 unless the node is an interrupt parent
+    u32 interrupt_parent{0}; // phandle from its own interrupt-parent property, 0 without
+    bool resolved{false};
+    bool interrupt_resolved{false}; // stays unset while the interrupt parent is not parsed
+};
+
+struct node_entry {
+    std::string_view name{}; // empty for the root of a file
+    index parent{npos};
+    u32 row{0}; // row within the parent
+    u32 rows_begin{0};
+    u32 row_count{0};
+    index deferred{npos}; // into tree::deferred while the rows have not been parsed yet
+    bool embedded{false}; // root of a blob embedded in a property, not part of the structure itself
+    cell_plan cells{};
+};
+
+struct property_entry {
+    name_id name{invalid_name_id};
+    index node{npos};
+    u32 row{0};
+    property_type type{property_type::guess}; // resolved at load, see fdt::resolve
+    std::string_view data;                    // view into one of tree::blobs
+};
+
+// flat, arena allocated device tree; nodes are stored before their descendants
+// and the rows of every node are contiguous in tree::rows
+struct tree {
+    tree() = default;
+    tree(tree &&) = default;
+    tree(const tree &) = delete; // roots of embedded blobs are named by views into names
+    auto operator=(tree &&) -> tree & = default;
+    auto operator=(const tree &) -> tree & = delete;
+
+    std::vector<blob> blobs;
+    name_table names;
+    std::vector<node_entry> nodes;
+    std::vector<property_entry> properties;
+    std::vector<entry> rows;
+    std::vector<fdt_span> deferred;
+    std::vector<u64> hashes; // per node, of the whole subtree; empty once stale, see update_hashes
+
+    auto children(const node_entry &value) const noexcept -> std::span<const entry> {
+        return {rows.data() + value.rows_begin, value.row_count};
+    }
+
+    auto name(const property_entry &value) const noexcept -> std::string_view {
+        return names.name(value.name);
+    }
+};
+
+class tree_builder : public iface_fdt_generator {
+public:
+    tree_builder(tree &target);
+
+    void begin_node(std::string_view name) noexcept final;
+    void end_node() noexcept final;
+    void insert_property(const fdt_property &property) noexcept final;
+    void deferred_node(std::string_view name, const fdt_span &span) noexcept final;
+
+    // until finalize() the builder doubles as an editable tree, used to merge overlays
+    auto find_child(index parent, std::string_view name) const noexcept -> index;
+    auto find_path(std::string_view path) const noexcept -> index;
+    auto find_property(index node, name_id name) const noexcept -> index;
+    auto path(index node) const -> std::string;
+
+    // continues emitting below an existing node
+    void enter(index node);
+    // like insert_property, but replaces a property of the same name
+    void set_property(const fdt_property &property) noexcept;
+
+    // lays out the rows of every node, must be called once the input is consumed
+    void finalize();
+
+private:
+    auto create_node(index parent, std::string_view name) -> index;
+    void append(index parent, entry value);
+    auto next(entry value) -> entry &;
+    auto next(entry value) const -> const entry &;
+
+    // child nodes by parent and name, blobs merged into one tree (embedded "data" nodes
+    // next to real children) would otherwise scan every sibling
+    struct child_key {
+        index parent{npos};
+        std::string_view name;
+        auto operator==(const child_key &) const -> bool = default;
+    };
+
+    struct child_key_hash {
+        auto operator()(const child_key &value) const noexcept -> std::size_t {
+            return std::hash<std::string_view>{}(value.name) ^ (static_cast<std::size_t>(value.parent) * 0x9e3779b97f4a7c15ull);
+        }
+    };
+
+private:
+    tree &m_tree;
+    std::unordered_map<child_key, index, child_key_hash> m_children;
+    std::vector<index> m_stack;
+    std::vector<entry> m_first;
+    std::vector<entry> m_last;
+    std::vector<entry> m_next_node;
+    std::vector<entry> m_next_property;
+};
+
+enum class parse_mode {
+    full, // every node of the blob, embedded blobs are still parsed on expansion
+    lazy, // only the root is parsed, other nodes keep their span until expanded
+};
+
+// rows of a deferred node, parsed but not yet attached to it
+struct expansion {
+    index node{npos};
+    u32 rows_begin{0};
+    u32 row_count{0};
+};
+
+// lookups in a finalized tree, linear in the number of rows of the nodes involved
+auto find_child(const tree &value, index node, std::string_view name) noexcept -> index;
+auto find_path(const tree &value, std::string_view path) noexcept -> index;
+auto find_property(const tree &value, index node, std::string_view name) noexcept -> const property_entry *;
+auto path(const tree &value, index node) -> std::string;
+
+// parses the blob into a new tree; embedded devicetree "data" blobs, inline or external
+// (data-offset, data-position), become deferred child nodes parsed by prepare_expansion
+auto parse_tree(const blob &source, parse_mode mode = parse_mode::full) -> std::optional<tree>;
+
+// parses the contents of a deferred node, its own children stay deferred; attaching
+// them is left to commit_expansion so models can announce the new rows in between
+auto prepare_expansion(tree &value, index node) -> expansion;
+void commit_expansion(tree &value, const expansion &rows) noexcept;
+
+// Merkle hash of every subtree over names and property data, equal subtrees of two trees
+// hash the same; a deferred node hashes its raw contents, so it only equals another
+// deferred node. finalize() fills them, expansions drop them
+void update_hashes(tree &value);
+
+} // namespace fdt
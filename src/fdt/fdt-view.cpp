@@ -1,206 +1,647 @@
 #include "fdt-view.hpp"
 
 #include <endian-conversions.hpp>
-#include <fdt/fdt-generator-qt.hpp>
-#include <fdt/fdt-parser.hpp>
+#include <fdt/fdt-address-map.hpp>
+#include <fdt/fdt-cells.hpp>
+#include <fdt/fdt-format.hpp>
+#include <fdt/fdt-loader.hpp>
 
-#include <QTreeWidget>
-#include <QTreeWidgetItem>
 #include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QItemSelectionModel>
+#include <QTimer>
+#include <QTreeView>
+#include <QtConcurrent>
 
-#include <stack>
+#include <array>
 
 namespace {
 constexpr auto BINARY_PREVIEW_LIMIT = 256;
 
-string present_u32be(const QByteArray &data) {
-    string ret;
-
-    auto array = reinterpret_cast<u8 *>(const_cast<char *>(data.data()));
-    for (auto i = 0; i < data.size(); ++i) {
-        ret += "0x" + QString::number(array[i], 16).rightJustified(2, '0').toUpper() + " ";
-        if (i == BINARY_PREVIEW_LIMIT) {
-            ret += "... ";
-            break;
-        }
-    }
-    ret.remove(ret.size() - 1, 1);
+// build tools write in several steps, a file is re-read after this long without changes
+constexpr auto RELOAD_DELAY_MS = 300;
 
+string present_cells(const std::string_view data, const fdt::cell_format format) {
+    string ret(static_cast<qsizetype>(fdt::formatted_size(data.size(), format, BINARY_PREVIEW_LIMIT)), Qt::Uninitialized);
+    const auto begin = reinterpret_cast<char16_t *>(ret.data());
+    ret.truncate(fdt::format_cells(data, format, begin, BINARY_PREVIEW_LIMIT) - begin);
     return ret;
 }
 
-string present(const fdt_property &property) {
-    auto &&name = property.name;
-    auto &&data = property.data;
+// converts the shown cells in one go; one entry more than the limit is read, so
+// format_entries still sees that the value was cut
+string present_entries(const std::string_view data, const u32 group) {
+    constexpr auto limit = BINARY_PREVIEW_LIMIT / 4;
+    std::vector<u32> cells(std::min<std::size_t>(data.size() / 4, limit + group));
+    read_cells_32be(data.data(), cells);
 
-    auto result = [&](string &&value) {
-        return name + " = <" + value + ">;";
-    };
+    string ret(static_cast<qsizetype>(fdt::entries_size(cells.size(), group, limit)), Qt::Uninitialized);
+    const auto begin = reinterpret_cast<char16_t *>(ret.data());
+    ret.truncate(fdt::format_entries(cells, group, begin, limit) - begin);
+    return ret;
+}
+
+// entry_cells splits reg, ranges and interrupts into entries, see fdt::entry_cells
+string present(const string &name, const fdt::property_entry &property, const u32 entry_cells = 0) {
+    const auto data = property.data;
 
     auto result_str = [&](string &&value) {
         return name + " = \"" + value + "\";";
     };
 
-    auto result_multi = [&](auto &value) {
-        auto lines = value.split(0);
-        lines.removeLast();
+    switch (property.type) {
+        case fdt::property_type::empty:
+            return name + ";";
+        case fdt::property_type::number:
+            return name + " = <" + string::number(read_data_32be<u32>(data.data())) + ">;";
+        case fdt::property_type::string:
+            return result_str(to_string(data.substr(0, data.size() - 1)));
+        case fdt::property_type::multiline: {
+            string ret;
+            for (std::size_t begin = 0; begin < data.size();) {
+                const auto end = data.find('\0', begin);
+                if (begin)
+                    ret += "\", \"";
+                ret += to_string(data.substr(begin, end - begin));
+                begin = end + 1;
+            }
+            return result_str(std::move(ret));
+        }
+        case fdt::property_type::bytes:
+            return name + " = " + present_cells(data, fdt::cell_format::bytes) + ";";
+        case fdt::property_type::hex:
+        case fdt::property_type::guess:
+            break;
+    }
+
+    if (entry_cells && !data.empty() && 0 == data.size() % (entry_cells * 4))
+        return name + " = " + present_entries(data, entry_cells) + ";";
+
+    return name + " = " + present_cells(data, fdt::cell_format::u32) + ";";
+}
+string present_address(const u64 value) {
+    return "0x" + string::number(value, 16).rightJustified(16, '0');
+}
+
+string present_region(const fdt::tree &tree, const fdt::region &value) {
+    constexpr std::array kinds{"device", "memory", "reserved", "memreserve"};
+    auto ret = present_address(value.first) + "-" + present_address(value.last) + "  " + string(kinds[static_cast<u8>(value.kind)]).leftJustified(10) + "  ";
+    if (fdt::npos == value.node)
+        return ret + "/memreserve/ #" + string::number(value.entry);
+
+    ret += to_string(fdt::path(tree, value.node));
+    if (value.entry)
+        ret += " #" + string::number(value.entry);
+
+    return ret;
+}
+} // namespace
+
+fdt::viewer::viewer(tree_view *target)
+        : QObject(nullptr)
+        , m_target(target)
+        , m_model(new tree_model(target))
+        , m_proxy(new tree_filter_model(target))
+        , m_search(new QFutureWatcher<search_result>(this))
+        , m_search_cancelled(std::make_shared<std::atomic_bool>(false))
+        , m_watcher(new QFileSystemWatcher(this))
+        , m_reload_timer(new QTimer(this))
+        , m_restore(new QFutureWatcher<loaded_file>(this)) {
+    m_proxy->setSourceModel(m_model);
+    m_target->setModel(m_proxy);
+
+    m_reload_timer->setSingleShot(true);
+    m_reload_timer->setInterval(RELOAD_DELAY_MS);
+
+    connect(m_search, &QFutureWatcherBase::finished, this, &viewer::finish_search);
+    connect(m_reload_timer, &QTimer::timeout, this, &viewer::reload_changed);
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, this, [this](const string &path) {
+        if (!m_changed.contains(path))
+            m_changed.append(path);
+
+        m_reload_timer->start();
+    });
+
+    // restored files are inserted as they finish, searched once per batch
+    connect(m_restore, &QFutureWatcherBase::resultsReadyAt, this, [this](int begin, int end) {
+        for (auto i = begin; i < end; ++i)
+            settle(m_restore->resultAt(i));
+
+        if (!m_query.isEmpty())
+            filter(m_query);
+
+        emit reloaded();
+    });
+
+    // placeholders are loaded before anyone looks at their contents; this runs ahead of
+    // the slots of the window, which was connected later
+    connect(m_target->selectionModel(), &QItemSelectionModel::selectionChanged, this, [this]() {
+        if (const auto info = m_model->info(selected()); nullptr != info && info->pending)
+            fetch(info->id);
+    });
+
+    connect(m_model, &tree_model::fetch_requested, this, [this](const string &id) {
+        if (!fetch(id))
+            return;
+
+        if (const auto info = m_model->find(id))
+            m_target->expand(m_proxy->mapFromSource(m_model->index(info->row, 0)));
+    }, Qt::QueuedConnection);
+}
+
+auto fdt::viewer::is_loaded(const string &id) const noexcept -> bool {
+    return nullptr != m_model->find(id);
+}
+
+bool fdt::viewer::load(const blob &datamap, string &&name, string &&id) {
+    auto tree = parse_tree(datamap, m_parse_mode);
+    if (!tree)
+        return false;
+
+    m_target->setCurrentIndex(insert(std::move(tree.value()), std::move(name), std::move(id)));
+    return true;
+}
+
+auto fdt::viewer::insert(tree &&value, string &&name, string &&id) -> QModelIndex {
+    watch(id);
+    const auto index = m_proxy->mapFromSource(m_model->load(std::move(value), std::move(name), std::move(id)));
+    m_target->expand(index);
+    return index;
+}
+
+void fdt::viewer::drop(const string &id) {
+    m_restored.remove(id);
+    m_watcher->removePath(id);
+    m_model->drop(id);
+}
+
+void fdt::viewer::clear() {
+    if (!m_watcher->files().isEmpty())
+        m_watcher->removePaths(m_watcher->files());
 
-        string ret;
-        for (auto i = 0; i < lines.count(); ++i) {
-            if (i == lines.count() - 1)
-                ret += lines[i];
-            else
-                ret += lines[i] + "\", \"";
+    m_restored.clear();
+    m_model->clear();
+}
+
+auto fdt::viewer::reload(const string &id, tree &&value) -> bool {
+    if (!m_model->reload(id, std::move(value)))
+        return false;
+
+    // a restored file that changed before it was loaded
+    resume(id);
+
+    // entries kept their hidden flag, new and changed ones are matched again
+    if (!m_query.isEmpty())
+        filter(m_query);
+
+    emit reloaded();
+    return true;
+}
+
+auto fdt::viewer::watch(const string &id) -> void {
+    if (file_info(id).isFile() && !m_watcher->files().contains(id))
+        m_watcher->addPath(id);
+}
+
+auto fdt::viewer::reload_changed() -> void {
+    for (auto &&path : std::exchange(m_changed, {})) {
+        if (!is_loaded(path))
+            continue;
+
+        // files replaced instead of rewritten lose their watch along with the old inode
+        watch(path);
+
+        // a half written file fails to parse, the write that completes it triggers another reload
+        const auto blob = load_file(path);
+        auto value = blob ? parse_tree(blob.value(), m_parse_mode) : std::nullopt;
+        if (value)
+            reload(path, std::move(value.value()));
+    }
+}
+
+auto fdt::viewer::restore(const fdt::session &value) -> void {
+    string_list paths;
+    for (auto &&id : value.files) {
+        const auto info = file_info(id);
+        if (is_loaded(id) || !info.isFile()) {
+            paths.append(string{});
+            continue;
         }
 
-        return result_str(std::move(ret));
+        m_model->placeholder(info.fileName(), string(id));
+        watch(id);
+        paths.append(id);
+    }
+
+    // "<file>:<path>[:<property>]", anything not pointing at a restored file is skipped
+    auto split = [&paths](const string &value) -> std::pair<string, string> {
+        const auto separator = value.indexOf(':');
+        const auto file = value.left(separator).toInt();
+        if (-1 == separator || file < 0 || file >= paths.size())
+            return {};
+
+        return {paths[file], value.mid(separator + 1)};
     };
 
-    if (property_map.contains(name)) {
-        const property_info info = property_map.value(name);
-        if (property_type::string == info.type)
-            return result_str({data});
+    for (auto &&expanded : value.expanded)
+        if (const auto [id, path] = split(expanded); !id.isEmpty())
+            m_restored[id].expanded.append(path);
+
+    if (const auto [id, path] = split(value.selected); !id.isEmpty())
+        m_restored[id].selected = path;
+
+    paths.removeAll(string{});
+    m_restore->setFuture(QtConcurrent::mapped(paths, [mode = m_parse_mode, cache = m_cache_directory](const string &path) {
+        return load_tree(path, mode, cache);
+    }));
+
+    if (!value.query.isEmpty())
+        filter(value.query);
+}
+
+auto fdt::viewer::session() const -> fdt::session {
+    fdt::session ret;
+    ret.query = m_query;
+
+    for (auto &&info : m_model->files()) {
+        // merged overlay trees have no file to come back to
+        if (!file_info(info->id).isFile())
+            continue;
+
+        const auto file = string::number(ret.files.size()) + ":";
+        ret.files.append(info->id);
+
+        // state of a file that was never loaded is carried over as it was restored
+        if (info->pending) {
+            const auto state = m_restored.value(info->id);
+            for (auto &&path : state.expanded)
+                ret.expanded.append(file + path);
+            if (!state.selected.isEmpty())
+                ret.selected = file + state.selected;
+            continue;
+        }
+
+        // preorder, parents are expanded again before their children
+        std::vector<QModelIndex> pending{m_proxy->mapFromSource(m_model->index(info->row, 0))};
+        while (!pending.empty()) {
+            const auto index = pending.back();
+            pending.pop_back();
 
-	if (property_type::multiline == info.type)
-	    return result_multi(data);
+            const auto value = m_model->entry_at(m_proxy->mapToSource(index));
+            if (entry_type::node != value.type || !m_target->isExpanded(index))
+                continue;
 
-        if (property_type::number == info.type)
-            return result(string::number(convert(*reinterpret_cast<const u32 *>(data.data()))));
+            ret.expanded.append(file + to_string(path(info->tree, value.value)));
+            for (auto row = m_proxy->rowCount(index); row-- > 0;)
+                pending.emplace_back(m_proxy->index(row, 0, index));
+        }
     }
 
-    const static QRegularExpression cells_regexp("^#.*-cells$");
-    const static QRegularExpression names_regexp("^.*-names");
+    const auto index = selected();
+    const auto info = m_model->info(index);
+    const auto file = nullptr == info ? -1 : ret.files.indexOf(info->id);
+    if (-1 == file || info->pending)
+        return ret;
+
+    const auto &tree = info->tree;
+    const auto value = m_model->entry_at(index);
+    if (entry_type::node == value.type)
+        ret.selected = string::number(file) + ":" + to_string(path(tree, value.value));
+    else
+        ret.selected = string::number(file) + ":" + to_string(path(tree, tree.properties[value.value].node)) + ":" + to_string(tree.name(tree.properties[value.value]));
 
-    if (cells_regexp.match(name).hasMatch())
-        return result(string::number(convert(*reinterpret_cast<const u32 *>(data.data()))));
+    return ret;
+}
 
-    if (names_regexp.match(name).hasMatch()) {
-        return result_multi(data);
+auto fdt::viewer::fetch(const string &id) -> bool {
+    const auto info = m_model->find(id);
+    if (nullptr == info || !info->pending)
+        return nullptr != info;
+
+    settle(load_tree(id, m_parse_mode, m_cache_directory));
+
+    if (!m_query.isEmpty())
+        filter(m_query);
+
+    emit reloaded();
+    return is_loaded(id);
+}
+
+auto fdt::viewer::settle(loaded_file &&value) -> void {
+    const auto info = m_model->find(value.path);
+    if (nullptr == info || !info->pending)
+        return;
+
+    // the file is no longer a devicetree, its placeholder goes away with it
+    if (!value.tree) {
+        m_restored.remove(value.path);
+        drop(value.path);
+        return;
     }
 
-    if (std::count_if(data.begin(), data.end(), [](auto &&value) { return value == 0x00; }) == 1 &&
-        data.at(data.size() - 1) == 0x00) return result_str({property.data});
+    m_model->reload(value.path, std::move(*value.tree));
+    resume(value.path);
+}
+
+auto fdt::viewer::resume(const string &id) -> void {
+    const auto state = m_restored.take(id);
 
-    return result(present_u32be(property.data));
+    for (auto &&path : state.expanded)
+        if (const auto index = locate(id, path); index.isValid())
+            m_target->expand(m_proxy->mapFromSource(index));
+
+    if (!state.selected.isEmpty())
+        select(locate(id, state.selected));
 }
-} // namespace
 
-fdt::viewer::viewer(tree_widget *target)
-        : m_target(target) {
+auto fdt::viewer::locate(const string &id, const string &path) -> QModelIndex {
+    const auto info = m_model->find(id);
+    if (nullptr == info || !path.startsWith('/'))
+        return {};
+
+    const auto separator = path.indexOf(':');
+    const auto node_path = path.left(separator);
+
+    // node names can be empty (embedded roots), only the leading separator is skipped;
+    // deferred nodes on the way are parsed
+    auto node = index{0};
+    for (auto &&name : node_path == "/" ? string_list{} : node_path.mid(1).split('/')) {
+        m_model->fetchMore(m_model->index_of(*info, {entry_type::node, node}));
+        node = find_child(info->tree, node, name.toStdString());
+        if (npos == node)
+            return {};
+    }
+
+    if (-1 == separator)
+        return m_model->index_of(*info, {entry_type::node, node});
+
+    m_model->fetchMore(m_model->index_of(*info, {entry_type::node, node}));
+    const auto property = find_property(info->tree, node, path.mid(separator + 1).toStdString());
+    if (nullptr == property)
+        return {};
+
+    return m_model->index_of(*info, {entry_type::property, static_cast<index>(property - info->tree.properties.data())});
 }
 
-auto fdt::viewer::is_loaded(string &&id) const noexcept -> bool {
-    return m_tree.contains(id);
+auto fdt::viewer::empty() const noexcept -> bool {
+    return m_model->files().empty();
 }
 
-auto fdt::viewer::is_loaded(const string &id) const noexcept -> bool {
-    return m_tree.contains(id);
+void fdt::viewer::filter(const string &query) {
+    m_query = query;
+
+    // the running search is abandoned, the new one starts once it stopped touching the trees
+    if (m_search->isRunning()) {
+        m_search_cancelled->store(true);
+        m_query_pending = true;
+        return;
+    }
+
+    start_search();
 }
 
-bool fdt::viewer::load(const byte_array &datamap, string &&name, string &&id) {
-    qt_tree_fdt_generator generator(m_tree[id], m_target, std::move(name), std::move(id));
+void fdt::viewer::start_search() {
+    m_query_pending = false;
 
-    std::vector<fdt_handle_special_property> handle_special_properties;
+    if (m_query.isEmpty()) {
+        for (auto &&info : m_model->files())
+            info->set_hidden(std::vector<u8>(info->hidden.size(), 0));
 
-    fdt_handle_special_property handle_inner_dt;
-    handle_inner_dt.name = "data";
-    handle_inner_dt.callback = [&handle_special_properties](const fdt_property &property, iface_fdt_generator &generator) {
-        fdt_parser(property.data.data(), property.data.size(), generator, property.name, handle_special_properties);
-    };
+        m_proxy->refresh();
+        emit search_finished();
+        return;
+    }
 
-    handle_special_properties.emplace_back(std::move(handle_inner_dt));
+    // search has to see the whole tree, deferred nodes are parsed first; workers only
+    // read the trees afterwards since nothing is left to fetch
+    for (auto &&info : m_model->files()) {
+        m_model->expand_all(m_model->index(info->row, 0));
+        prepare_search(*info);
+    }
 
-    fdt_parser parser(datamap.data(), datamap.size(), generator, {}, handle_special_properties);
+    const QList<std::shared_ptr<tree_info>> files(m_model->files().begin(), m_model->files().end());
 
-    if (!parser.is_valid()) {
-        return false;
+    m_search_cancelled = std::make_shared<std::atomic_bool>(false);
+    m_search->setFuture(QtConcurrent::mapped(files, [query = m_query, cancelled = m_search_cancelled](const std::shared_ptr<tree_info> &info) {
+        return search_result{info, fdt_content_match(*info, query, *cancelled)};
+    }));
+
+    emit search_started();
+}
+
+void fdt::viewer::finish_search() {
+    if (m_query_pending) {
+        start_search();
+        return;
+    }
+
+    // results are applied in one batch, files dropped or reloaded meanwhile are skipped
+    for (auto &&result : m_search->future().results()) {
+        const auto info = m_model->find(result.info->id);
+        if (info != result.info.get() || !result.hidden || result.hidden->size() != info->tree.nodes.size())
+            continue;
+
+        info->set_hidden(std::move(result.hidden.value()));
     }
 
+    m_proxy->refresh();
+    emit search_finished();
+}
+
+auto fdt::viewer::selected() const -> QModelIndex {
+    const auto selection = m_target->selectionModel()->selectedIndexes();
+    if (selection.isEmpty())
+        return {};
+
+    return m_proxy->mapToSource(selection.first());
+}
+
+auto fdt::viewer::select(const QModelIndex &index) -> bool {
+    const auto target = m_proxy->mapFromSource(index);
+    if (!target.isValid())
+        return false;
+
+    m_target->setCurrentIndex(target);
+    m_target->scrollTo(target);
     return true;
 }
 
-void fdt::viewer::drop(string &&id) {
-    m_tree.remove(id);
+auto fdt::fdt_view_property(tree_info &info, const index id) -> string {
+    const auto &property = info.tree.properties[id];
+    info.phandles.update(info.tree);
+    const auto &cells = resolve_cells(info.tree, info.phandles, property.node);
+    return present(info.name_string(property.name), property, entry_cells(cells, property.name));
 }
 
-bool fdt::fdt_content_filter(tree_widget_item *node, const std::function<bool(const string &)> &match) {
-    QList<tree_widget_item *> nodes;
-    QList<tree_widget_item *> properties;
+auto fdt::fdt_view_address_map(tree_info &info) -> string {
+    const auto &tree = info.tree;
+    if (!info.addresses || info.addresses->nodes != tree.nodes.size()) {
+        info.phandles.update(info.tree);
+        info.addresses = build_address_map(info.tree, info.phandles);
+    }
 
-    for (auto i = 0; i < node->childCount(); ++i) {
-        const auto child = node->child(i);
-        switch (child->data(0, QT_ROLE_NODETYPE).value<NodeType>()) {
-            case NodeType::Node:
-                nodes.append(child);
-                break;
-            case NodeType::Property:
-                properties.append(child);
-                break;
-        }
+    const auto regions = info.addresses->regions.regions();
+    std::vector<u8> overlapping(regions.size(), 0);
+
+    string ret;
+    for (auto [lhs, rhs] : info.addresses->overlaps) {
+        overlapping[lhs] = overlapping[rhs] = 1;
+        ret += "! " + present_region(tree, regions[lhs]) + "\n    overlaps " + present_region(tree, regions[rhs]) + "\n";
     }
 
-    const auto name = node->data(0, Qt::DisplayRole).toString();
+    if (!ret.isEmpty())
+        ret += "\n";
 
-    bool isFound = match(name);
+    for (std::size_t i = 0; i < regions.size(); ++i)
+        ret += (overlapping[i] ? "! " : "  ") + present_region(tree, regions[i]) + "\n";
 
-    for (auto item : properties) {
-        if (isFound)
-            break;
+    return ret;
+}
 
-        const auto property = item->data(0, QT_ROLE_PROPERTY).value<fdt_property>();
-        isFound |= match(property.name) || match(present(property));
-    }
+auto fdt::fdt_view_diff(tree_info &left, tree_info &right, std::span<const difference> differences) -> string {
+    string ret = "--- " + left.name + "\n+++ " + right.name + "\n";
+
+    auto line = [](const char *prefix, tree_info &info, const entry value) {
+        const auto &tree = info.tree;
+        if (entry_type::node == value.type)
+            return prefix + to_string(path(tree, value.value)) + "\n";
 
-    for (auto i = 0; i < nodes.count(); ++i) {
-        isFound |= fdt::fdt_content_filter(nodes.at(i), match);
+        return prefix + to_string(path(tree, tree.properties[value.value].node)) + ": " + fdt_view_property(info, value.value) + "\n";
+    };
+
+    for (auto &&difference : differences) {
+        if (change::added != difference.kind)
+            ret += line("- ", left, {difference.type, difference.left});
+        if (change::removed != difference.kind)
+            ret += line("+ ", right, {difference.type, difference.right});
     }
 
-    node->setHidden(!isFound);
+    return ret;
+}
+
+auto fdt::prepare_search(tree_info &info) -> void {
+    info.phandles.update(info.tree);
+    for (index node = 0; node < info.tree.nodes.size(); ++node)
+        resolve_cells(info.tree, info.phandles, node);
+}
+
+auto fdt::fdt_content_search(tree_info &info, const string &query, const std::atomic_bool &cancelled) -> std::optional<std::vector<u8>> {
+    const auto &tree = info.tree;
+    std::vector<u8> found(tree.nodes.size(), 0);
+
+    // the presented text contains the property name, one entry covers both; names are
+    // decoded here instead of through tree_info::name_string which belongs to the GUI thread
+    const auto indexed = info.search.update(
+        tree,
+        [&info](const index id) { return info.node_name(id); },
+        [&tree](const index id) {
+            const auto &property = tree.properties[id];
+            // plans were resolved by prepare_search, the worker only reads them
+            return present(to_string(tree.name(property)), property, entry_cells(tree.nodes[property.node].cells, property.name));
+        },
+        cancelled);
+
+    if (!indexed || !info.search.match(query, found, cancelled))
+        return {};
+
+    return found;
+}
+
+auto fdt::fdt_content_match(tree_info &info, const string &query, const std::atomic_bool &cancelled) -> std::optional<std::vector<u8>> {
+    auto found = fdt_content_search(info, query, cancelled);
+    if (!found)
+        return {};
+
+    // nodes are stored before their descendants, a reverse pass propagates matches to every ancestor
+    const auto &tree = info.tree;
+    for (auto i = tree.nodes.size(); i-- > 0;)
+        if ((*found)[i] && npos != tree.nodes[i].parent)
+            (*found)[tree.nodes[i].parent] = 1;
 
-    return isFound;
+    for (auto &&value : *found)
+        value = !value;
+
+    return found;
 }
 
-bool fdt::fdt_view_dts(tree_widget_item *item, string &ret, int depth) {
-    string depth_str;
-    depth_str.fill(' ', depth * 4);
+auto fdt::fdt_view_dts(tree_info &info, const index id) -> string {
+    if (info.hidden[id])
+        return {};
+
+    if (const auto cached = info.dts.object(id))
+        return *cached;
 
-    QList<tree_widget_item *> nodes;
-    QList<tree_widget_item *> properties;
+    const auto &tree = info.tree;
+    const auto &node = tree.nodes[id];
 
-    for (auto i = 0; i < item->childCount(); ++i) {
-        const auto child = item->child(i);
-        switch (child->data(0, QT_ROLE_NODETYPE).value<NodeType>()) {
-            case NodeType::Node:
-                nodes.append(child);
+    // contents that are not parsed yet are left to the tree view, selecting never parses
+    // more than the selected node itself; its cells are resolved once it is expanded
+    if (npos != node.deferred)
+        return info.node_name(id) + " {\n    /* not loaded, expand the node to parse it */\n};\n";
+
+    info.phandles.update(info.tree);
+    const auto cells = resolve_cells(info.tree, info.phandles, id);
+    if (!cells.interrupt_resolved)
+        info.provisional.insert(id);
+
+    QList<index> nodes;
+    QList<index> properties;
+
+    for (auto &&child : tree.children(node)) {
+        switch (child.type) {
+            case entry_type::node:
+                nodes.append(child.value);
                 break;
-            case NodeType::Property:
-                properties.append(child);
+            case entry_type::property:
+                properties.append(child.value);
                 break;
         }
     }
 
-    if (item->isHidden())
-        return false;
+    string ret;
+    if (npos == node.parent && !tree.blobs.empty())
+        for (auto &&entry : read_reservations(tree.blobs.front().data))
+            ret += "/memreserve/ " + present_address(entry.address) + " " + present_address(entry.size) + ";\n";
+
+    if (!ret.isEmpty())
+        ret += "\n";
 
-    ret += depth_str + item->data(0, Qt::DisplayRole).toString() + " {\n";
+    ret += info.node_name(id) + " {\n";
 
-    for (auto item : properties) {
-        const auto property = item->data(0, QT_ROLE_PROPERTY).value<fdt_property>();
-        ret += depth_str + "    " + present(property) + "\n";
+    for (auto property : properties) {
+        const auto &value = tree.properties[property];
+        ret += "    " + present(info.name_string(value.name), value, entry_cells(cells, value.name)) + "\n";
     }
 
     if (!properties.isEmpty() && !nodes.isEmpty())
         ret += "\n";
 
-    for (auto i = 0; i < nodes.count(); ++i) {
-        if (!fdt_view_dts(nodes.at(i), ret, depth + 1))
+    // children come from the cache and are only shifted by one level
+    auto first = true;
+    for (auto child : nodes) {
+        const auto text = fdt_view_dts(info, child);
+        if (text.isEmpty())
             continue;
 
-        if (nodes.count() - 1 != i)
+        if (!first)
             ret += "\n";
+
+        first = false;
+
+        const auto view = QStringView(text);
+        for (qsizetype begin = 0; begin < view.size();) {
+            const auto end = view.indexOf(u'\n', begin) + 1;
+            const auto line = view.mid(begin, (end ? end : view.size()) - begin);
+            if (line != u"\n")
+                ret += "    ";
+
+            ret += line;
+            begin = end ? end : view.size();
+        }
     }
 
-    ret += depth_str + "};\n";
+    ret += "};\n";
 
-    return true;
+    info.dts.insert(id, new string(ret), ret.size());
+    return ret;
 }
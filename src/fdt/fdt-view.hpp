@@ -1,26 +1,133 @@
 #pragma once
 
-#include <fdt/fdt-generator-qt.hpp>
+#include <fdt/fdt-diff.hpp>
+#include <fdt/fdt-loader.hpp>
+#include <fdt/fdt-tree-model.hpp>
+
+#include <QFutureWatcher>
+#include <QHash>
+#include <QObject>
+
+class QFileSystemWatcher;
+class QTimer;
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
 
 namespace fdt {
 
-class viewer {
+struct search_result {
+    std::shared_ptr<tree_info> info;
+    std::optional<std::vector<u8>> hidden; // empty when the search was cancelled
+};
+
+// open files and what was shown of them, nodes are named by their path within the file
+struct session {
+    string_list files;
+    string_list expanded; // "<file>:<path>" in preorder, file is an index into files
+    string selected;      // "<file>:<path>", a selected property appends ":<name>"
+    string query;
+};
+
+class viewer : public QObject {
+    Q_OBJECT
 public:
-    viewer(tree_widget *target);
+    viewer(tree_view *target);
 
-    auto is_loaded(string &&id) const noexcept -> bool;
     auto is_loaded(const string &id) const noexcept -> bool;
 
-    auto load(const byte_array &datamap, string &&name, string &&id) -> bool;
-    auto drop(string &&id) -> void;
+    auto load(const blob &datamap, string &&name, string &&id) -> bool;
+    auto insert(tree &&value, string &&name, string &&id) -> QModelIndex;
+    auto drop(const string &id) -> void;
+    auto reload(const string &id, tree &&value) -> bool;
+    auto clear() -> void;
+    auto empty() const noexcept -> bool;
+
+    auto set_parse_mode(parse_mode mode) noexcept -> void { m_parse_mode = mode; }
+    auto get_parse_mode() const noexcept -> parse_mode { return m_parse_mode; }
+    auto set_cache_directory(const string &path) -> void { m_cache_directory = path; }
+    auto get_cache_directory() const -> const string & { return m_cache_directory; }
+
+    // shows placeholders for the files right away and parses them on the thread pool;
+    // a file touched before that is parsed on the spot, see fetch
+    auto restore(const fdt::session &value) -> void;
+    auto session() const -> fdt::session;
+    // replaces the placeholder of a restored file with its tree, false if it is gone
+    auto fetch(const string &id) -> bool;
+
+    // matches every loaded file on the thread pool, a newer query cancels the one in flight
+    auto filter(const string &query) -> void;
+
+    auto selected() const -> QModelIndex;
+    // selects and reveals a model index, entries hidden by the search stay unselected
+    auto select(const QModelIndex &index) -> bool;
+    auto model() noexcept -> tree_model & { return *m_model; }
+
+signals:
+    void search_started();
+    void search_finished();
+    void reloaded();
 
 private:
-    tree_map m_tree;
-    tree_widget *m_target;
+    auto start_search() -> void;
+    auto finish_search() -> void;
+    auto watch(const string &id) -> void;
+    auto reload_changed() -> void;
+    auto settle(loaded_file &&value) -> void;
+    auto resume(const string &id) -> void;
+    auto locate(const string &id, const string &path) -> QModelIndex;
+
+private:
+    tree_view *m_target;
+    tree_model *m_model;
+    tree_filter_model *m_proxy;
+    parse_mode m_parse_mode{parse_mode::full};
+
+    QFutureWatcher<search_result> *m_search;
+    std::shared_ptr<std::atomic_bool> m_search_cancelled;
+    string m_query;
+    bool m_query_pending{false};
+
+    // loaded files are re-read once they stop changing
+    QFileSystemWatcher *m_watcher;
+    QTimer *m_reload_timer;
+    string_list m_changed;
+
+    // restored files still waiting for their tree, and the view state to apply to it
+    struct view_state {
+        string_list expanded;
+        string selected;
+    };
+
+    string m_cache_directory;
+    QFutureWatcher<loaded_file> *m_restore;
+    QHash<string, view_state> m_restored;
 };
 
-bool fdt_view_prepare(tree_widget *target, const byte_array &datamap, const file_info &info);
-bool fdt_view_dts(tree_widget_item *item, string &ret, int depth = 0);
-bool fdt_content_filter(tree_widget_item *item, const std::function<bool(const string &)> &match);
+// renders a node and its visible descendants at depth 0, subtrees are cached in tree_info::dts;
+// deferred nodes below it have to be expanded first
+auto fdt_view_dts(tree_info &info, index node) -> string;
+auto fdt_view_property(tree_info &info, index property) -> string;
+
+// physical address map of every parsed node, overlaps first and then all regions by
+// address; rebuilt once lazy nodes were parsed since the last call
+auto fdt_view_address_map(tree_info &info) -> string;
+
+// lists the differences of two trees one path per line, prefixed like a unified diff
+auto fdt_view_diff(tree_info &left, tree_info &right, std::span<const difference> differences) -> string;
+
+// resolves the cell plans the search renders property text with, on the thread owning info;
+// the search itself only reads them
+auto prepare_search(tree_info &info) -> void;
+
+// flags the nodes matching the query themselves, by name or through one of their properties
+auto fdt_content_search(tree_info &info, const string &query, const std::atomic_bool &cancelled) -> std::optional<std::vector<u8>>;
+
+// returns the hidden flag of every node, safe to run on a worker thread while no other
+// search touches the same tree_info
+auto fdt_content_match(tree_info &info, const string &query, const std::atomic_bool &cancelled) -> std::optional<std::vector<u8>>;
 
 } // namespace fdt
@@ -0,0 +1,280 @@
+#include "fdt-writer.hpp"
+
+#include <endian-conversions.hpp>
+#include <fdt/fdt-header.hpp>
+
+#include <array>
+#include <limits>
+#include <string>
+#include <unordered_map>
+
+namespace {
+constexpr auto FDT_VERSION = 17u;
+constexpr auto FDT_LAST_COMPATIBLE_VERSION = 16u;
+constexpr auto WRITE_BUFFER_SIZE = 64 * 1024;
+
+constexpr auto aligned(const std::size_t size) noexcept -> std::size_t {
+    return (size + 3) & ~std::size_t{3};
+}
+
+// dtc and libfdt reuse the first position of the table where a name is found, suffixes of
+// earlier names included; the same rule keeps the offsets of an unmodified blob
+class string_table {
+public:
+    void seed(std::string_view block) {
+        m_data.assign(block);
+        index(0);
+    }
+
+    auto insert(std::string_view name) -> u32 {
+        if (const auto iter = m_offsets.find(name); m_offsets.end() == iter) {
+            const auto offset = m_data.size();
+            m_data.append(name).push_back('\0');
+            index(offset);
+        }
+
+        return m_offsets.find(name)->second;
+    }
+
+    auto data() const noexcept -> std::string_view { return m_data; }
+
+private:
+    void index(const std::size_t from) {
+        for (auto begin = from; begin < m_data.size();) {
+            const auto end = m_data.find('\0', begin);
+            if (std::string::npos == end)
+                break;
+
+            for (auto i = begin; i <= end; ++i)
+                m_offsets.try_emplace(std::string(m_data, i, end - i), static_cast<u32>(i));
+
+            begin = end + 1;
+        }
+    }
+
+    struct hash {
+        using is_transparent = void;
+        auto operator()(std::string_view value) const noexcept -> std::size_t { return std::hash<std::string_view>{}(value); }
+    };
+
+    std::string m_data;
+    std::unordered_map<std::string, u32, hash, std::equal_to<>> m_offsets;
+};
+
+class blob_writer {
+public:
+    blob_writer(const fdt::tree &value, const fdt::write_options &options, const fdt::write_sink &sink)
+            : m_tree(value)
+            , m_options(options)
+            , m_sink(sink)
+            , m_nameoffs(value.names.size(), fdt::npos) {
+        m_buffer.reserve(WRITE_BUFFER_SIZE);
+    }
+
+    auto write() -> bool {
+        if (m_options.root >= m_tree.nodes.size())
+            return false;
+
+        // a whole blob keeps the reservations, boot cpu and strings it was read with
+        fdt::header source{};
+        std::string_view reservations;
+        if (const auto data = source_blob(); data.size() >= sizeof(fdt::header)) {
+            source = read_data_32be<fdt::header>(data.data());
+            if (FDT_MAGIC_VALUE == source.magic && source.off_dt_strings + u64{source.size_dt_strings} <= data.size() && source.off_dt_struct + u64{source.size_dt_struct} <= data.size()) {
+                m_strings.seed(data.substr(source.off_dt_strings, source.size_dt_strings));
+                m_source_struct = data.substr(source.off_dt_struct, source.size_dt_struct);
+            }
+            if (FDT_MAGIC_VALUE == source.magic && source.off_mem_rsvmap < source.off_dt_struct && source.off_dt_struct <= data.size())
+                reservations = data.substr(source.off_mem_rsvmap, source.off_dt_struct - source.off_mem_rsvmap);
+        }
+
+        // the first pass sizes the structure block and settles the strings, the second writes
+        std::size_t size_dt_struct = sizeof(fdt::token);
+        if (!measure(m_options.root, size_dt_struct))
+            return false;
+
+        const auto rsvmap = used_reservations(reservations);
+        const auto off_dt_struct = sizeof(fdt::header) + rsvmap.size() + 2 * sizeof(u64);
+        const auto off_dt_strings = off_dt_struct + size_dt_struct;
+        const auto totalsize = off_dt_strings + m_strings.data().size();
+        if (totalsize > std::numeric_limits<u32>::max())
+            return false;
+
+        const std::array<u32, 10> header{
+            FDT_MAGIC_VALUE,
+            static_cast<u32>(totalsize),
+            static_cast<u32>(off_dt_struct),
+            static_cast<u32>(off_dt_strings),
+            static_cast<u32>(sizeof(fdt::header)),
+            FDT_VERSION,
+            FDT_LAST_COMPATIBLE_VERSION,
+            source.boot_cpuid_phys,
+            static_cast<u32>(m_strings.data().size()),
+            static_cast<u32>(size_dt_struct),
+        };
+
+        for (auto &&field : header)
+            put(field);
+
+        append(rsvmap);
+        append(std::string_view("\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0", 2 * sizeof(u64)));
+
+        emit(m_options.root);
+        put(static_cast<u32>(fdt::token::end));
+
+        append(m_strings.data());
+        return flush();
+    }
+
+private:
+    auto visible(const fdt::index id) const noexcept -> bool {
+        const auto &node = m_tree.nodes[id];
+        if (node.embedded && id != m_options.root)
+            return false;
+
+        return nullptr == m_options.hidden || id >= m_options.hidden->size() || !(*m_options.hidden)[id];
+    }
+
+    auto measure(const fdt::index id, std::size_t &size) -> bool {
+        const auto &node = m_tree.nodes[id];
+        if (fdt::npos != node.deferred)
+            return false;
+
+        size += 2 * sizeof(fdt::token) + aligned(name(id).size() + 1);
+
+        for (auto &&child : m_tree.children(node)) {
+            if (fdt::entry_type::node == child.type) {
+                if (visible(child.value) && !measure(child.value, size))
+                    return false;
+                continue;
+            }
+
+            const auto &property = m_tree.properties[child.value];
+            if (fdt::npos == source_nameoff(property) && fdt::npos == m_nameoffs[property.name])
+                m_nameoffs[property.name] = m_strings.insert(m_tree.name(property));
+
+            size += sizeof(fdt::token) + sizeof(fdt::property) + aligned(property.data.size());
+        }
+
+        return true;
+    }
+
+    void emit(const fdt::index id) {
+        const auto &node = m_tree.nodes[id];
+
+        put(static_cast<u32>(fdt::token::begin_node));
+        padded(name(id), 1);
+
+        for (auto &&child : m_tree.children(node)) {
+            if (fdt::entry_type::node == child.type) {
+                if (visible(child.value))
+                    emit(child.value);
+                continue;
+            }
+
+            const auto &property = m_tree.properties[child.value];
+            put(static_cast<u32>(fdt::token::property));
+            put(static_cast<u32>(property.data.size()));
+            const auto nameoff = source_nameoff(property);
+            put(fdt::npos == nameoff ? m_nameoffs[property.name] : nameoff);
+            padded(property.data, 0);
+        }
+
+        put(static_cast<u32>(fdt::token::end_node));
+    }
+
+    // the blob a root was parsed from, the file itself or the "data" property holding it
+    auto source_blob() const noexcept -> std::string_view {
+        const auto &root = m_tree.nodes[m_options.root];
+        if (fdt::npos == root.parent)
+            return m_tree.blobs.empty() ? std::string_view{} : m_tree.blobs.front().data;
+
+        if (!root.embedded)
+            return {};
+
+        const auto property = fdt::find_property(m_tree, root.parent, "data");
+        return nullptr == property ? std::string_view{} : property->data;
+    }
+
+    // properties still in the structure block of the source keep their name offset, it is
+    // stored right in front of the value; generators differ in how they share strings
+    auto source_nameoff(const fdt::property_entry &property) const noexcept -> u32 {
+        const auto begin = m_source_struct.data();
+        const auto value = property.data.data();
+        if (nullptr == begin || value < begin + sizeof(fdt::token) + sizeof(fdt::property) || value > begin + m_source_struct.size())
+            return fdt::npos;
+
+        const auto nameoff = read_data_32be<u32>(value - sizeof(u32));
+        const auto strings = m_strings.data();
+        const auto name = m_tree.name(property);
+        if (nameoff >= strings.size() || strings.substr(nameoff, name.size()) != name || strings.size() == nameoff + name.size() || '\0' != strings[nameoff + name.size()])
+            return fdt::npos;
+
+        return nameoff;
+    }
+
+    // the root of the new blob is always nameless
+    auto name(const fdt::index id) const noexcept -> std::string_view {
+        return id == m_options.root ? std::string_view{} : m_tree.nodes[id].name;
+    }
+
+    // entries up to the terminating zero pair, the terminator is written separately
+    static auto used_reservations(std::string_view data) noexcept -> std::string_view {
+        constexpr auto entry_size = 2 * sizeof(u64);
+        for (std::size_t i = 0; i + entry_size <= data.size(); i += entry_size)
+            if (data.substr(i, entry_size) == std::string_view("\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0", entry_size))
+                return data.substr(0, i);
+
+        return {};
+    }
+
+    void put(const u32 value) {
+        const auto be = convert(value);
+        append(std::string_view(reinterpret_cast<const char *>(&be), sizeof(be)));
+    }
+
+    void padded(std::string_view data, const std::size_t terminator) {
+        append(data);
+        constexpr std::string_view zeros("\0\0\0\0", 4);
+        append(zeros.substr(0, aligned(data.size() + terminator) - data.size()));
+    }
+
+    // large property values go to the sink as they are, small writes are gathered
+    void append(std::string_view data) {
+        if (!m_ok)
+            return;
+
+        if (m_buffer.size() + data.size() > WRITE_BUFFER_SIZE && !flush())
+            return;
+
+        if (data.size() >= WRITE_BUFFER_SIZE) {
+            m_ok = m_sink(data);
+            return;
+        }
+
+        m_buffer.append(data);
+    }
+
+    auto flush() -> bool {
+        if (m_ok && !m_buffer.empty())
+            m_ok = m_sink(m_buffer);
+
+        m_buffer.clear();
+        return m_ok;
+    }
+
+private:
+    const fdt::tree &m_tree;
+    const fdt::write_options &m_options;
+    const fdt::write_sink &m_sink;
+    std::vector<u32> m_nameoffs; // per name id
+    string_table m_strings;
+    std::string_view m_source_struct;
+    std::string m_buffer;
+    bool m_ok{true};
+};
+} // namespace
+
+auto fdt::write_blob(const tree &value, const write_options &options, const write_sink &sink) -> bool {
+    return blob_writer(value, options, sink).write();
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <fdt/fdt-tree.hpp>
+
+#include <functional>
+#include <string_view>
+#include <vector>
+
+namespace fdt {
+
+// receives the serialized blob in order, returns false to abort
+using write_sink = std::function<bool(std::string_view data)>;
+
+struct write_options {
+    index root{0};                          // written as the root node of the new blob
+    const std::vector<u8> *hidden{nullptr}; // per node, flagged subtrees are left out
+};
+
+// serializes a subtree as a version 17 blob; the layout follows dtc, so an unmodified tree
+// comes out byte-identical. Embedded blobs stay in their "data" property, deferred nodes
+// have to be expanded first
+auto write_blob(const tree &value, const write_options &options, const write_sink &sink) -> bool;
+
+} // namespace fdt
@@ -6,13 +6,23 @@
 #include <QDir>
 #include <QDirIterator>
 #include <QFile>
+#include <QFutureWatcher>
+#include <QLabel>
 #include <QMessageBox>
-#include <QTreeWidget>
+#include <QProgressDialog>
+#include <QSaveFile>
+#include <QTimer>
+#include <QTreeView>
+#include <QtConcurrent>
+
+#include <optional>
 
 #include <dialogs.hpp>
 #include <endian-conversions.hpp>
-#include <fdt/fdt-parser.hpp>
+#include <fdt/fdt-loader.hpp>
+#include <fdt/fdt-overlay.hpp>
 #include <fdt/fdt-view.hpp>
+#include <fdt/fdt-writer.hpp>
 #include <menu-manager.hpp>
 #include <viewer-settings.hpp>
 
@@ -21,6 +31,17 @@
 
 using namespace Window;
 
+namespace {
+// typing pauses shorter than this do not start a search
+constexpr auto SEARCH_DEBOUNCE_MS = 150;
+
+// ids of trees produced by applying overlays, they have no file of their own
+const auto OVERLAY_ID_PREFIX = string("overlay://");
+
+// links listed above the preview, a node like a clock provider can have hundreds of users
+constexpr auto MAX_REFERENCE_LINKS = 64;
+} // namespace
+
 MainWindow::MainWindow(QWidget *parent)
         : QMainWindow(parent)
         , m_ui(std::make_unique<Ui::MainWindow>()) {
@@ -29,7 +50,7 @@ MainWindow::MainWindow(QWidget *parent)
     m_ui->preview->setCurrentWidget(m_ui->text_view_page);
     m_ui->splitter->setEnabled(false);
 
-    m_viewer = std::make_unique<fdt::viewer>(m_ui->treeWidget);
+    m_viewer = std::make_unique<fdt::viewer>(m_ui->treeView);
 
     m_hexview = new QHexView();
     m_hexview->setReadOnly(true);
@@ -49,6 +70,10 @@ MainWindow::MainWindow(QWidget *parent)
         m_ui->text_view->setWordWrapMode(value ? QTextOption::WordWrap : QTextOption::NoWrap);
     });
 
+    connect(m_menu.get(), &menu_manager::use_lazy_loading, [this](const bool value) {
+        m_viewer->set_parse_mode(value ? fdt::parse_mode::lazy : fdt::parse_mode::full);
+    });
+
     connect(m_menu.get(), &menu_manager::show_about_qt, []() { QApplication::aboutQt(); });
 
     connect(m_menu.get(), &menu_manager::open_file, this, [this]() {
@@ -59,41 +84,80 @@ MainWindow::MainWindow(QWidget *parent)
         fdt::open_directory_dialog(this, [this](auto &&...values) { open_directory(std::forward<decltype(values)>(values)...); });
     });
 
-    connect(m_ui->quick_search, &QLineEdit::textEdited, this, [this](const QString &text) {
-        auto node = m_ui->treeWidget->invisibleRootItem();
+    m_search_timer = new QTimer(this);
+    m_search_timer->setSingleShot(true);
+    m_search_timer->setInterval(SEARCH_DEBOUNCE_MS);
 
-        fdt::fdt_content_filter(
-            node, [&text](const string &value) -> bool {
-                if (text.isEmpty())
-                    return true;
+    m_search_indicator = new QLabel(tr("Searching…"));
+    m_search_indicator->setVisible(false);
+    m_ui->statusbar->addPermanentWidget(m_search_indicator);
 
-                return value.indexOf(text) != -1;
-            });
+    connect(m_ui->quick_search, &QLineEdit::textEdited, m_search_timer, qOverload<>(&QTimer::start));
+    connect(m_search_timer, &QTimer::timeout, this, [this]() {
+        m_viewer->filter(m_ui->quick_search->text());
+    });
 
+    connect(m_viewer.get(), &fdt::viewer::search_started, m_search_indicator, &QLabel::show);
+    connect(m_viewer.get(), &fdt::viewer::search_finished, this, [this]() {
+        m_search_indicator->hide();
         update_view();
     });
+    connect(m_viewer.get(), &fdt::viewer::reloaded, this, &MainWindow::update_view);
 
     connect(m_menu.get(), &menu_manager::quit, this, &MainWindow::close);
     connect(m_menu.get(), &menu_manager::close, this, [this]() {
-        if (m_fdt) {
-            delete m_fdt;
-            m_fdt = nullptr;
+        const auto info = m_viewer->model().info(m_viewer->selected());
+        if (info) {
+            m_viewer->drop(info->id);
             update_view();
         }
     });
 
     connect(m_menu.get(), &menu_manager::property_export, this, &MainWindow::property_export);
 
+    connect(m_menu.get(), &menu_manager::apply_overlays, this, [this]() {
+        fdt::open_overlays_dialog(this, [this](const string_list &paths) { apply_overlays(paths); });
+    });
+
+    connect(m_menu.get(), &menu_manager::compare, this, [this]() {
+        const auto info = m_viewer->model().info(m_viewer->selected());
+        if (nullptr == info)
+            return;
+
+        string_list ids;
+        for (auto &&file : m_viewer->model().files())
+            if (file.get() != info)
+                ids.append(file->id);
+
+        fdt::compare_with_dialog(this, ids, [this, ids](const int choice) { compare_with(ids[choice]); });
+    });
+
+    connect(m_menu.get(), &menu_manager::export_blob, this, [this]() {
+        const auto index = m_viewer->selected();
+        if (!index.isValid())
+            return;
+
+        auto hint = file_info(m_viewer->model().info(index)->name).completeBaseName();
+        if (index.parent().isValid())
+            hint += "-" + index.data().toString();
+
+        fdt::save_blob_dialog(this, hint + ".dtb", [this](const string &path) { export_blob(path); });
+    });
+
+    connect(m_menu.get(), &menu_manager::address_map, this, &MainWindow::show_address_map);
+
     connect(m_menu.get(), &menu_manager::close_all, this, [this]() {
-        m_fdt = nullptr;
-        m_ui->treeWidget->clear();
+        m_viewer->clear();
         update_view();
     });
 
-    connect(m_ui->treeWidget, &QTreeWidget::itemSelectionChanged, this, &MainWindow::update_view);
+    connect(m_ui->treeView->selectionModel(), &QItemSelectionModel::selectionChanged, this, &MainWindow::update_view);
+    connect(m_ui->references, &QLabel::linkActivated, this, &MainWindow::follow_reference);
 
     viewer_settings settings;
     m_ui->text_view->setWordWrapMode(settings.view_word_wrap.value() ? QTextOption::WordWrap : QTextOption::NoWrap);
+    m_viewer->set_parse_mode(settings.load_lazy_children.value() ? fdt::parse_mode::lazy : fdt::parse_mode::full);
+    m_viewer->set_cache_directory(settings.load_cache_directory.value());
 
     if (settings.window_show_fullscreen.value())
         showFullScreen();
@@ -107,14 +171,87 @@ MainWindow::MainWindow(QWidget *parent)
 MainWindow::~MainWindow() {
     viewer_settings settings;
     settings.window_position.set(geometry());
+
+    const auto session = m_viewer->session();
+    settings.session_files.set(session.files);
+    settings.session_expanded.set(session.expanded);
+    settings.session_selected.set(session.selected);
+    settings.session_query.set(session.query);
+}
+
+void MainWindow::restore_session() {
+    viewer_settings settings;
+    fdt::session session{
+        .files = settings.session_files.value(),
+        .expanded = settings.session_expanded.value(),
+        .selected = settings.session_selected.value(),
+        .query = settings.session_query.value(),
+    };
+
+    m_ui->quick_search->setText(session.query);
+    m_viewer->restore(session);
+    update_view();
 }
 
 void MainWindow::open_directory(const string &path) {
+    string_list paths;
+    std::optional<bool> reload;
+
     QDirIterator iter(path, {"*.dtb", "*.dtbo"}, QDir::Files);
     while (iter.hasNext()) {
         iter.next();
-        open_file(iter.filePath());
+
+        if (m_viewer->is_loaded(iter.fileInfo().absoluteFilePath())) {
+            if (!reload)
+                reload = !dialogs::ask_already_opened(this);
+
+            if (!reload.value())
+                continue;
+        }
+
+        paths.append(iter.filePath());
     }
+
+    if (paths.isEmpty())
+        return;
+
+    // files are read and parsed on the global thread pool, finished trees are inserted in batches
+    auto watcher = new QFutureWatcher<fdt::loaded_file>(this);
+    auto progress = new QProgressDialog(tr("Loading %1").arg(path), tr("Cancel"), 0, paths.size(), this);
+    auto failed = std::make_shared<string_list>();
+
+    progress->setWindowModality(Qt::WindowModal);
+    progress->setMinimumDuration(500);
+
+    connect(watcher, &QFutureWatcherBase::progressValueChanged, progress, &QProgressDialog::setValue);
+    connect(progress, &QProgressDialog::canceled, watcher, &QFutureWatcherBase::cancel);
+
+    connect(watcher, &QFutureWatcherBase::resultsReadyAt, this, [this, watcher, failed](int begin, int end) {
+        for (auto i = begin; i < end; ++i) {
+            const auto result = watcher->resultAt(i);
+            if (!result.tree) {
+                failed->append(result.path);
+                continue;
+            }
+
+            const auto info = file_info(result.path);
+            m_viewer->insert(std::move(*result.tree), info.fileName(), info.absoluteFilePath());
+        }
+    });
+
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, progress, failed]() {
+        progress->deleteLater();
+        watcher->deleteLater();
+        update_view();
+
+        if (!failed->isEmpty())
+            dialogs::warn_invalid_fdt(*failed, this);
+    });
+
+    // an unchanged file of a large directory is restored from the parse cache instead of parsed
+    watcher->setFuture(QtConcurrent::mapped(paths, [mode = m_viewer->get_parse_mode(), cache = m_viewer->get_cache_directory()](const string &path) {
+        return fdt::load_tree(path, mode, cache);
+    }));
 }
 
 void MainWindow::open_file(const string &path) {
@@ -123,87 +260,240 @@ void MainWindow::open_file(const string &path) {
 }
 
 bool MainWindow::open(const string &path) {
-    QFile file(path);
-    if (!file.open(QIODevice::ReadOnly))
-        return false;
-
     const auto info = file_info(path);
 
     if (m_viewer->is_loaded(info.absoluteFilePath()) &&
         dialogs::ask_already_opened(this))
         return true;
 
-    const auto ret = m_viewer->load(file.readAll(), info.fileName(), info.absoluteFilePath());
+    const auto blob = fdt::load_file(path);
+    if (!blob)
+        return false;
+
+    const auto ret = m_viewer->load(blob.value(), info.fileName(), info.absoluteFilePath());
     update_view();
     return ret;
 }
 
-void MainWindow::update_fdt_path(QTreeWidgetItem *item) {
-    m_menu->set_close_enabled(item);
+void MainWindow::update_fdt_path(const QModelIndex &index) {
+    m_menu->set_close_enabled(index.isValid());
 
-    if (nullptr == item) {
+    if (!index.isValid()) {
         m_ui->path->clear();
         return;
     }
 
-    QString path = item->text(0);
-    auto root = item;
-    while (root->parent()) {
-        path = root->parent()->text(0) + "/" + path;
-        root = root->parent();
-    }
+    QString path = index.data().toString();
+    for (auto parent = index.parent(); parent.isValid(); parent = parent.parent())
+        path = parent.data().toString() + "/" + path;
 
-    m_fdt = root;
-
-    m_ui->statusbar->showMessage("file://" + root->data(0, QT_ROLE_FILEPATH).toString());
+    m_ui->statusbar->showMessage("file://" + index.data(QT_ROLE_FILEPATH).toString());
     m_ui->path->setText("fdt://" + path);
 }
 
-constexpr auto VIEW_TEXT_CACHE_SIZE = 1024 * 1024;
-
 void MainWindow::update_view() {
-    m_ui->splitter->setEnabled(m_ui->treeWidget->topLevelItemCount());
-    m_menu->set_close_enabled(!m_ui->treeWidget->selectedItems().isEmpty());
-    m_menu->set_close_all_enabled(m_ui->treeWidget->topLevelItemCount());
+    const auto index = m_viewer->selected();
+
+    m_ui->splitter->setEnabled(!m_viewer->empty());
+    m_menu->set_close_enabled(index.isValid());
+    m_menu->set_close_all_enabled(!m_viewer->empty());
+    m_menu->set_apply_overlays_enabled(index.isValid());
+    m_menu->set_compare_enabled(index.isValid() && m_viewer->model().files().size() > 1);
+    m_menu->set_export_blob_enabled(index.isValid() && fdt::entry_type::node == m_viewer->model().entry_at(index).type);
+    m_menu->set_address_map_enabled(index.isValid());
 
-    if (m_ui->treeWidget->selectedItems().isEmpty()) {
+    if (!index.isValid()) {
         m_ui->preview->setCurrentWidget(m_ui->text_view_page);
         m_ui->text_view->clear();
         m_ui->statusbar->clearMessage();
         m_ui->path->clear();
+        m_ui->references->hide();
         return;
     }
 
-    const auto item = m_ui->treeWidget->selectedItems().first();
+    auto &info = *m_viewer->model().info(index);
+    const auto entry = m_viewer->model().entry_at(index);
 
-    const auto type = item->data(0, QT_ROLE_NODETYPE).value<NodeType>();
-    m_ui->preview->setCurrentWidget(NodeType::Node == type ? m_ui->text_view_page : m_ui->property_view_page);
+    const auto is_node = fdt::entry_type::node == entry.type;
+    m_ui->preview->setCurrentWidget(is_node ? m_ui->text_view_page : m_ui->property_view_page);
 
-    if (NodeType::Property == type) {
-        const auto property = item->data(0, QT_ROLE_PROPERTY).value<fdt_property>();
-        m_hexview->setDocument(QHexDocument::fromMemory<QMemoryBuffer>(property.data));
+    if (!is_node) {
+        const auto &property = info.tree.properties[entry.value];
+        m_hexview->setDocument(QHexDocument::fromMemory<QMemoryBuffer>(byte_array(property.data.data(), property.data.size())));
     }
 
     m_ui->text_view->clear();
-    update_fdt_path(item);
+    update_fdt_path(index);
 
-    string ret;
-    ret.reserve(VIEW_TEXT_CACHE_SIZE);
+    if (!is_node)
+        return update_references(info, entry);
 
-    fdt::fdt_view_dts(item, ret);
-    m_ui->text_view->setText(ret);
+    // only the rows of the selected node are parsed, deferred children show a placeholder
+    if (m_viewer->model().canFetchMore(index))
+        m_viewer->model().fetchMore(index);
+
+    m_ui->text_view->setText(fdt::fdt_view_dts(info, entry.value));
+    update_references(info, entry);
+}
+
+void MainWindow::update_references(tree_info &info, const fdt::entry entry) {
+    const auto &tree = info.tree;
+    info.phandles.update(tree);
+
+    const auto is_node = fdt::entry_type::node == entry.type;
+    const auto links = is_node ? info.phandles.users(entry.value) : info.phandles.targets(entry.value);
+
+    if (links.empty()) {
+        m_ui->references->hide();
+        return;
+    }
+
+    string_list items;
+    for (auto &&link : links.first(std::min<std::size_t>(links.size(), MAX_REFERENCE_LINKS))) {
+        // users are properties, targets are nodes
+        const auto path = is_node ? fdt::path(tree, tree.properties[link].node) + ":" + std::string(tree.name(tree.properties[link])) : fdt::path(tree, link);
+        const auto href = string(is_node ? "property:%1" : "node:%1").arg(link);
+        items.append(string("<a href=\"%1\">%2</a>").arg(href, to_string(path).toHtmlEscaped()));
+    }
+
+    if (links.size() > MAX_REFERENCE_LINKS)
+        items.append(tr("%n more", nullptr, static_cast<int>(links.size() - MAX_REFERENCE_LINKS)));
+
+    m_ui->references->setText((is_node ? tr("Referenced by: ") : tr("Points to: ")) + items.join(", "));
+    m_ui->references->show();
+}
+
+void MainWindow::follow_reference(const string &link) {
+    const auto info = m_viewer->model().info(m_viewer->selected());
+    const auto separator = link.indexOf(':');
+    if (nullptr == info || -1 == separator)
+        return;
+
+    const auto type = link.left(separator) == "property" ? fdt::entry_type::property : fdt::entry_type::node;
+    const auto value = link.mid(separator + 1).toUInt();
+    const auto count = fdt::entry_type::property == type ? info->tree.properties.size() : info->tree.nodes.size();
+    if (value >= count)
+        return;
+
+    if (!m_viewer->select(m_viewer->model().index_of(*info, {type, value})))
+        m_ui->statusbar->showMessage(tr("The target is hidden by the current search"));
 }
 
 void MainWindow::property_export() {
-    if (m_ui->treeWidget->selectedItems().isEmpty())
+    const auto index = m_viewer->selected();
+    if (!index.isValid())
+        return;
+
+    auto &info = *m_viewer->model().info(index);
+    const auto entry = m_viewer->model().entry_at(index);
+
+    if (fdt::entry_type::property == entry.type) {
+        const auto &property = info.tree.properties[entry.value];
+        const auto data = byte_array(property.data.data(), property.data.size());
+        m_hexview->setDocument(QHexDocument::fromMemory<QMemoryBuffer>(data));
+        fdt::export_property_file_dialog(this, data, info.name_string(property.name));
+    }
+}
+
+void MainWindow::apply_overlays(const string_list &paths) {
+    const auto info = m_viewer->model().info(m_viewer->selected());
+    if (nullptr == info)
         return;
 
-    const auto item = m_ui->treeWidget->selectedItems().first();
-    const auto type = item->data(0, QT_ROLE_NODETYPE).value<NodeType>();
+    // the base blob of a merged tree would silently drop the overlays applied before
+    if (info->id.startsWith(OVERLAY_ID_PREFIX)) {
+        dialogs::warn_overlay_failed(tr("Select a devicetree blob as the base, not a merged tree."), this);
+        return;
+    }
+
+    std::vector<fdt::blob> overlays;
+    string name = info->name;
+    for (auto &&path : paths) {
+        auto blob = fdt::load_file(path);
+        if (!blob) {
+            dialogs::warn_invalid_fdt(path, this);
+            return;
+        }
+
+        overlays.emplace_back(std::move(blob.value()));
+        name += " + " + file_info(path).fileName();
+    }
 
-    if (NodeType::Property == type) {
-        const auto property = item->data(0, QT_ROLE_PROPERTY).value<fdt_property>();
-        m_hexview->setDocument(QHexDocument::fromMemory<QMemoryBuffer>(property.data));
-        fdt::export_property_file_dialog(this, property.data, property.name);
+    auto result = fdt::apply_overlays(info->tree.blobs.front(), overlays);
+    if (!result.value) {
+        dialogs::warn_overlay_failed(to_string(result.error), this);
+        return;
     }
+
+    auto id = OVERLAY_ID_PREFIX + info->id;
+    for (auto &&path : paths)
+        id += "|" + file_info(path).absoluteFilePath();
+
+    m_ui->treeView->setCurrentIndex(m_viewer->insert(std::move(result.value.value()), std::move(name), std::move(id)));
+    update_view();
+}
+
+void MainWindow::compare_with(const string &id) {
+    auto &model = m_viewer->model();
+    // the other file may still be a placeholder of the restored session
+    m_viewer->fetch(id);
+
+    const auto left = model.info(m_viewer->selected());
+    const auto right = model.find(id);
+    if (nullptr == left || nullptr == right)
+        return;
+
+    // hashes cover parsed rows only, both trees are compared in full
+    for (auto &&info : {left, right})
+        model.expand_all(model.index(info->row, 0));
+
+    const auto differences = fdt::diff(left->tree, right->tree);
+
+    m_ui->preview->setCurrentWidget(m_ui->text_view_page);
+    m_ui->references->hide();
+    m_ui->text_view->setPlainText(fdt::fdt_view_diff(*left, *right, differences));
+    m_ui->statusbar->showMessage(tr("%n difference(s)", nullptr, static_cast<int>(differences.size())));
+}
+
+void MainWindow::show_address_map() {
+    auto &model = m_viewer->model();
+    const auto info = model.info(m_viewer->selected());
+    if (nullptr == info)
+        return;
+
+    // every reg counts, deferred nodes are parsed first
+    model.expand_all(model.index(info->row, 0));
+
+    const auto text = fdt::fdt_view_address_map(*info);
+
+    m_ui->preview->setCurrentWidget(m_ui->text_view_page);
+    m_ui->references->hide();
+    m_ui->text_view->setPlainText(text);
+    m_ui->statusbar->showMessage(tr("%n region(s), %1 overlap(s)", nullptr, static_cast<int>(info->addresses->regions.regions().size())).arg(info->addresses->overlaps.size()));
+}
+
+void MainWindow::export_blob(const string &path) {
+    auto &model = m_viewer->model();
+    const auto index = m_viewer->selected();
+    const auto info = model.info(index);
+    if (nullptr == info || fdt::entry_type::node != model.entry_at(index).type)
+        return;
+
+    // the selected subtree is written as shown, nodes hidden by the search are left out
+    model.expand_all(index);
+
+    const fdt::write_options options{
+        .root = model.entry_at(index).value,
+        .hidden = &info->hidden,
+    };
+
+    QSaveFile output(path);
+    const auto written = output.open(QIODevice::WriteOnly) &&
+        fdt::write_blob(info->tree, options, [&output](std::string_view data) {
+            return output.write(data.data(), static_cast<qint64>(data.size())) == static_cast<qint64>(data.size());
+        }) &&
+        output.commit();
+
+    if (!written)
+        dialogs::warn_export_failed(path, this);
 }
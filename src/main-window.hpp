@@ -5,10 +5,13 @@
 #include <QMainWindow>
 #include <memory>
 
+class QLabel;
+class QTimer;
+
 #include <fdt/fdt-view.hpp>
 
 class QHexView;
-class QTreeWidgetItem;
+class QModelIndex;
 class menu_manager;
 
 namespace Window {
@@ -31,17 +34,27 @@ public:
 
     bool open(const string &path);
 
+    // reopens the files of the last session, their trees are parsed in the background
+    void restore_session();
+
 private:
-    void update_fdt_path(QTreeWidgetItem *item = nullptr);
+    void update_fdt_path(const QModelIndex &index);
     void update_view();
+    void update_references(tree_info &info, fdt::entry entry);
+    void follow_reference(const string &link);
     void property_export();
+    void apply_overlays(const string_list &paths);
+    void compare_with(const string &id);
+    void export_blob(const string &path);
+    void show_address_map();
 
 private:
     QHexView *m_hexview{nullptr};
     std::unique_ptr<Ui::MainWindow> m_ui;
     std::unique_ptr<menu_manager> m_menu;
-    tree_widget_item *m_fdt{nullptr};
     std::unique_ptr<fdt::viewer> m_viewer;
+    QTimer *m_search_timer{nullptr};
+    QLabel *m_search_indicator{nullptr};
 };
 
 } // namespace Window
@@ -1,3 +1,4 @@
+#include "batch-mode.hpp"
 #include "main-window.hpp"
 
 #include <QApplication>
@@ -6,6 +7,8 @@
 #include <QFileInfo>
 #include <QSettings>
 
+#include <memory>
+
 #include <config.h>
 
 int main(int argc, char *argv[]) {
@@ -14,23 +17,50 @@ int main(int argc, char *argv[]) {
     const auto patch = QString::number(PROJECT_VERSION_PATCH);
     const auto version_string = major + "." + minor + "." + patch;
 
-    QApplication application(argc, argv);
-
-    application.setOrganizationName(PROJECT_NAME);
-    application.setApplicationName(PROJECT_NAME);
-    application.setApplicationVersion(version_string);
-    application.setApplicationDisplayName(QString("Flattened Device Tree Viewer %1").arg(version_string));
+    // reports run without a display, widgets are never initialised
+    const auto headless = batch::requested(argc, argv);
+    std::unique_ptr<QCoreApplication> application;
+    if (headless)
+        application = std::make_unique<QCoreApplication>(argc, argv);
+    else
+        application = std::make_unique<QApplication>(argc, argv);
 
-    QSettings settings;
+    QCoreApplication::setOrganizationName(PROJECT_NAME);
+    QCoreApplication::setApplicationName(PROJECT_NAME);
+    QCoreApplication::setApplicationVersion(version_string);
 
     QCommandLineParser parser;
     QCommandLineOption file_option{{"f", "file"}, QCoreApplication::translate("main", "open file."), "file"};
     QCommandLineOption dir_option{{"d", "directory"}, QCoreApplication::translate("main", "open directory."), "directory"};
+    QCommandLineOption dump_option{"dump", QCoreApplication::translate("main", "print the inputs as DTS to stdout.")};
+    QCommandLineOption query_option{"query", QCoreApplication::translate("main", "print the node or property at path."), "path"};
+    QCommandLineOption search_option{"search", QCoreApplication::translate("main", "print the paths of nodes matching text."), "text"};
+    QCommandLineOption stats_option{"stats", QCoreApplication::translate("main", "print node and property counts.")};
     parser.addHelpOption();
     parser.addVersionOption();
-    parser.addOptions({file_option, dir_option});
+    parser.addOptions({file_option, dir_option, dump_option, query_option, search_option, stats_option});
+    parser.addPositionalArgument("inputs", QCoreApplication::translate("main", "files or directories to open."), "[inputs...]");
+
+    parser.process(*application);
+
+    if (headless) {
+        batch::options options;
+        options.dump = parser.isSet(dump_option);
+        options.stats = parser.isSet(stats_option);
+        if (parser.isSet(query_option))
+            options.query = parser.value(query_option);
+        if (parser.isSet(search_option))
+            options.search = parser.value(search_option);
 
-    parser.process(application);
+        auto inputs = parser.positionalArguments();
+        inputs.append(parser.values(file_option));
+        inputs.append(parser.values(dir_option));
+        return batch::run(options, inputs);
+    }
+
+    QApplication::setApplicationDisplayName(QString("Flattened Device Tree Viewer %1").arg(version_string));
+
+    QSettings settings;
 
     Window::MainWindow window;
     window.show();
@@ -44,7 +74,7 @@ int main(int argc, char *argv[]) {
         window.open_file(parser.value(file_option));
 
     if (no_parameters) {
-        auto args = application.arguments();
+        auto args = QCoreApplication::arguments();
         args.removeFirst();
         for (auto &&path : args) {
             auto info = QFileInfo{path};
@@ -54,7 +84,11 @@ int main(int argc, char *argv[]) {
             if (info.isFile())
                 window.open_file(path);
         }
+
+        // started without inputs, the files of the last session come back
+        if (args.isEmpty())
+            window.restore_session();
     }
 
-    return application.exec();
+    return QApplication::exec();
 }
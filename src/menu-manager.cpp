@@ -14,22 +14,33 @@ menu_manager::menu_manager(menu_bar *menubar)
     auto help_menu = menubar->addMenu(tr("&Help"));
     auto file_menu_open = new QAction("Open");
     auto file_menu_open_dir = new QAction("Open directory");
+    auto file_menu_apply_overlays = new QAction("Apply Overlays…");
+    auto file_menu_compare = new QAction("Compare With…");
+    auto file_menu_export_blob = new QAction("Export Blob…");
     auto file_menu_close = new QAction("Close");
     auto file_menu_close_all = new QAction("Close All");
     auto file_menu_quit = new QAction("Quit");
     auto property_export = new QAction("Export");
     auto help_menu_about_qt = new QAction("About Qt");
     auto view_menu_word_wrap = new QAction("Word Wrap");
+    auto view_menu_lazy_loading = new QAction("Load Children On Demand");
+    auto view_menu_address_map = new QAction("Address Map");
     auto window_menu_full_screen = new QAction("Full screen");
     help_menu->addAction(help_menu_about_qt);
     file_menu->addAction(file_menu_open);
     file_menu->addAction(file_menu_open_dir);
+    file_menu->addAction(file_menu_apply_overlays);
+    file_menu->addAction(file_menu_compare);
+    file_menu->addAction(file_menu_export_blob);
     file_menu->addSeparator();
     file_menu->addAction(file_menu_close);
     file_menu->addAction(file_menu_close_all);
     file_menu->addSeparator();
     file_menu->addAction(file_menu_quit);
     view_menu->addAction(view_menu_word_wrap);
+    view_menu->addAction(view_menu_lazy_loading);
+    view_menu->addSeparator();
+    view_menu->addAction(view_menu_address_map);
     property_menu->addAction(property_export);
     window_menu->addAction(window_menu_full_screen);
     file_menu_close->setShortcut(QKeySequence::Close);
@@ -37,6 +48,7 @@ menu_manager::menu_manager(menu_bar *menubar)
     file_menu_quit->setShortcut(QKeySequence::Quit);
     window_menu_full_screen->setShortcut(QKeySequence::FullScreen);
     view_menu_word_wrap->setCheckable(true);
+    view_menu_lazy_loading->setCheckable(true);
     file_menu_close->setIcon(QIcon::fromTheme("document-close"));
     file_menu_close_all->setIcon(QIcon::fromTheme("document-close"));
     file_menu_open->setIcon(QIcon::fromTheme("document-open"));
@@ -46,10 +58,15 @@ menu_manager::menu_manager(menu_bar *menubar)
     window_menu_full_screen->setIcon(QIcon::fromTheme("view-fullscreen"));
     window_menu_full_screen->setCheckable(true);
     file_menu_close->setEnabled(false);
+    file_menu_apply_overlays->setEnabled(false);
+    file_menu_compare->setEnabled(false);
+    file_menu_export_blob->setEnabled(false);
+    view_menu_address_map->setEnabled(false);
     file_menu_close_all->setEnabled(false);
 
     viewer_settings settings;
     view_menu_word_wrap->setChecked(settings.view_word_wrap.value());
+    view_menu_lazy_loading->setChecked(settings.load_lazy_children.value());
     window_menu_full_screen->setChecked(settings.window_show_fullscreen.value());
 
     connect(this, &menu_manager::use_word_wrap, [](auto &&value) {
@@ -57,13 +74,23 @@ menu_manager::menu_manager(menu_bar *menubar)
         settings.view_word_wrap.set(value);
     });
 
+    connect(this, &menu_manager::use_lazy_loading, [](auto &&value) {
+        viewer_settings settings;
+        settings.load_lazy_children.set(value);
+    });
+
     connect(file_menu_quit, &action::triggered, this, &menu_manager::quit);
     connect(view_menu_word_wrap, &action::triggered, this, &menu_manager::use_word_wrap);
+    connect(view_menu_lazy_loading, &action::triggered, this, &menu_manager::use_lazy_loading);
     connect(file_menu_close, &action::triggered, this, &menu_manager::close);
     connect(file_menu_close_all, &action::triggered, this, &menu_manager::close_all);
     connect(help_menu_about_qt, &action::triggered, this, &menu_manager::show_about_qt);
     connect(file_menu_open, &action::triggered, this, &menu_manager::open_file);
     connect(file_menu_open_dir, &action::triggered, this, &menu_manager::open_directory);
+    connect(file_menu_apply_overlays, &action::triggered, this, &menu_manager::apply_overlays);
+    connect(file_menu_compare, &action::triggered, this, &menu_manager::compare);
+    connect(file_menu_export_blob, &action::triggered, this, &menu_manager::export_blob);
+    connect(view_menu_address_map, &action::triggered, this, &menu_manager::address_map);
     connect(property_export, &action::triggered, this, &menu_manager::property_export);
     connect(window_menu_full_screen, &action::triggered, [this](bool value) {
         viewer_settings settings;
@@ -78,6 +105,10 @@ menu_manager::menu_manager(menu_bar *menubar)
 
     m_close_action = file_menu_close;
     m_close_all_action = file_menu_close_all;
+    m_apply_overlays_action = file_menu_apply_overlays;
+    m_compare_action = file_menu_compare;
+    m_export_blob_action = file_menu_export_blob;
+    m_address_map_action = view_menu_address_map;
 }
 
 void menu_manager::set_close_enabled(const bool value) {
@@ -87,3 +118,19 @@ void menu_manager::set_close_enabled(const bool value) {
 void menu_manager::set_close_all_enabled(const bool value) {
     m_close_all_action->setEnabled(value);
 }
+
+void menu_manager::set_apply_overlays_enabled(const bool value) {
+    m_apply_overlays_action->setEnabled(value);
+}
+
+void menu_manager::set_compare_enabled(const bool value) {
+    m_compare_action->setEnabled(value);
+}
+
+void menu_manager::set_export_blob_enabled(const bool value) {
+    m_export_blob_action->setEnabled(value);
+}
+
+void menu_manager::set_address_map_enabled(const bool value) {
+    m_address_map_action->setEnabled(value);
+}
@@ -11,10 +11,18 @@ public:
 public:
     void set_close_enabled(bool value);
     void set_close_all_enabled(bool value);
+    void set_apply_overlays_enabled(bool value);
+    void set_compare_enabled(bool value);
+    void set_export_blob_enabled(bool value);
+    void set_address_map_enabled(bool value);
 
 signals:
     void open_file();
     void open_directory();
+    void apply_overlays();
+    void compare();
+    void export_blob();
+    void address_map();
     void close();
     void close_all();
     void quit();
@@ -23,6 +31,7 @@ signals:
     void show_about_qt();
 
     void use_word_wrap(bool);
+    void use_lazy_loading(bool);
 
     void show_full_screen();
     void show_normal();
@@ -30,4 +39,8 @@ signals:
 private:
     action *m_close_action{nullptr};
     action *m_close_all_action{nullptr};
+    action *m_apply_overlays_action{nullptr};
+    action *m_compare_action{nullptr};
+    action *m_export_blob_action{nullptr};
+    action *m_address_map_action{nullptr};
 };
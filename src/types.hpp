@@ -1,19 +1,10 @@
 #pragma once
 
-#include <cstdint>
+#include <integer-types.hpp>
+
 #include <QStringList>
 #include <QRegularExpression>
 
-using i16 = std::int16_t;
-using i32 = std::int32_t;
-using i64 = std::int64_t;
-using i8 = std::int8_t;
-
-using u16 = std::uint16_t;
-using u32 = std::uint32_t;
-using u64 = std::uint64_t;
-using u8 = std::uint8_t;
-
 class QAction;
 class QActionGroup;
 class QMenuBar;
@@ -23,8 +14,7 @@ class QFile;
 class QFileInfo;
 class QRegExp;
 class QString;
-class QTreeWidget;
-class QTreeWidgetItem;
+class QTreeView;
 class QWidget;
 
 using action = QAction;
@@ -36,6 +26,5 @@ using file = QFile;
 using file_info = QFileInfo;
 using string = QString;
 using string_list = QStringList;
-using tree_widget = QTreeWidget;
-using tree_widget_item = QTreeWidgetItem;
+using tree_view = QTreeView;
 using widget = QWidget;
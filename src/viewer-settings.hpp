@@ -35,6 +35,12 @@ public:
     viewer_settings() = default;
 
     settings_property<bool> view_word_wrap{"view/word_wrap", true};
+    settings_property<bool> load_lazy_children{"load/lazy_children", false};
+    settings_property<string> load_cache_directory{"load/cache_directory", {}}; // empty disables the parse cache
     settings_property<bool> window_show_fullscreen{"window/fullscreen", false};
     settings_property<QRect> window_position{"window/position", {}};
+    settings_property<string_list> session_files{"session/files", {}};
+    settings_property<string_list> session_expanded{"session/expanded", {}};
+    settings_property<string> session_selected{"session/selected", {}};
+    settings_property<string> session_query{"session/query", {}};
 };